@@ -0,0 +1,259 @@
+#pragma once
+
+#include "dijkstra_router.h"
+#include "router.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+    // ALT engine: A* search with landmark lower bounds.
+    // For every landmark L the distances L -> v and v -> L are precomputed, then by the triangle inequality
+    // dist(v, t) >= dist(L, t) - dist(L, v) and dist(v, t) >= dist(v, L) - dist(t, L).
+    // The best of these bounds directs the search towards the target and cuts off most of the graph.
+    template <typename Weight>
+    class AltRouter : public RouterBase<Weight> {
+    private:
+        using Graph = CsrGraph<Weight>;
+
+    public:
+        using RouteInfo = typename RouterBase<Weight>::RouteInfo;
+
+        // The landmark distances are computed on the pool, which has to outlive the router
+        AltRouter(const Graph& graph, std::vector<VertexId> landmarks, thread_pool::ThreadPool& pool);
+
+        std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+
+        // Landmark bounds direct the search to a single target, so many targets are served by plain Dijkstra
+        std::vector<std::optional<RouteInfo>> BuildRoutes(VertexId from, const std::vector<VertexId>& targets) const override;
+
+        // Increased weights leave the landmark bounds valid, only a decrease makes them recomputed
+        bool UpdateEdgeWeights(const std::vector<std::pair<EdgeId, Weight>>& old_weights) override;
+
+        // Number of vertices settled by the last query of the calling thread
+        static size_t GetLastSettledCount();
+
+    private:
+        struct AltSearchData : detail::SearchData<Weight> {
+            std::vector<Weight> potentials;
+        };
+
+        static AltSearchData& GetSearchData() {
+            thread_local AltSearchData search_data;
+            return search_data;
+        }
+
+        void BuildReverseArcs();
+        void ComputeLandmarkDistances();
+
+        // Distances from the source to every vertex, along the edges or against them
+        std::vector<Weight> ComputeDistances(VertexId source, bool is_reversed) const;
+
+        Weight ComputePotential(VertexId vertex, VertexId target) const;
+
+        static constexpr Weight ZERO_WEIGHT{};
+        static constexpr Weight UNREACHABLE = std::numeric_limits<Weight>::max();
+        static constexpr EdgeId NO_EDGE = detail::SearchData<Weight>::NO_EDGE;
+
+        const Graph& graph_;
+        thread_pool::ThreadPool& pool_;
+        std::vector<VertexId> landmarks_;
+
+        // Incoming arcs of every vertex in the same layout, for the distances to the landmarks
+        std::vector<size_t> reverse_offsets_;
+        std::vector<uint32_t> reverse_sources_;
+        std::vector<Weight> reverse_weights_;
+
+        // landmark_index * vertex_count + vertex
+        std::vector<Weight> distances_from_landmarks_;
+        std::vector<Weight> distances_to_landmarks_;
+    };
+
+    template <typename Weight>
+    AltRouter<Weight>::AltRouter(const Graph& graph, std::vector<VertexId> landmarks, thread_pool::ThreadPool& pool)
+        : graph_(graph)
+        , pool_(pool)
+        , landmarks_(std::move(landmarks))
+    {
+        for (size_t arc = 0; arc < graph.GetEdgeCount(); ++arc) {
+            if (graph.GetArcWeight(arc) < ZERO_WEIGHT) {
+                throw std::domain_error("Edges' weights should be non-negative");
+            }
+        }
+        for (const VertexId landmark : landmarks_) {
+            if (landmark >= graph.GetVertexCount()) {
+                throw std::out_of_range("Landmark vertex id is out of range");
+            }
+        }
+        BuildReverseArcs();
+        ComputeLandmarkDistances();
+    }
+
+    template <typename Weight>
+    bool AltRouter<Weight>::UpdateEdgeWeights(const std::vector<std::pair<EdgeId, Weight>>& old_weights) {
+        // The reverse arcs are read only by the landmark searches, so they are refreshed together
+        for (const auto& [edge_id, old_weight] : old_weights) {
+            const VertexId from = graph_.GetEdgeInfo(edge_id).from;
+            for (size_t arc = graph_.GetArcsBegin(from); arc < graph_.GetArcsEnd(from); ++arc) {
+                if (graph_.GetArcEdge(arc) == edge_id && graph_.GetArcWeight(arc) < old_weight) {
+                    BuildReverseArcs();
+                    ComputeLandmarkDistances();
+                    return true;
+                }
+            }
+        }
+        return true;
+    }
+
+    template <typename Weight>
+    void AltRouter<Weight>::BuildReverseArcs() {
+        const size_t vertex_count = graph_.GetVertexCount();
+        reverse_offsets_.assign(vertex_count + 1, 0);
+        for (size_t arc = 0; arc < graph_.GetEdgeCount(); ++arc) {
+            ++reverse_offsets_[graph_.GetArcTarget(arc) + 1];
+        }
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            reverse_offsets_[vertex + 1] += reverse_offsets_[vertex];
+        }
+        reverse_sources_.resize(graph_.GetEdgeCount());
+        reverse_weights_.resize(graph_.GetEdgeCount());
+        std::vector<size_t> positions(reverse_offsets_.begin(), std::prev(reverse_offsets_.end()));
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            for (size_t arc = graph_.GetArcsBegin(vertex); arc < graph_.GetArcsEnd(vertex); ++arc) {
+                const size_t position = positions[graph_.GetArcTarget(arc)]++;
+                reverse_sources_[position] = static_cast<uint32_t>(vertex);
+                reverse_weights_[position] = graph_.GetArcWeight(arc);
+            }
+        }
+    }
+
+    template <typename Weight>
+    void AltRouter<Weight>::ComputeLandmarkDistances() {
+        const size_t vertex_count = graph_.GetVertexCount();
+        distances_from_landmarks_.resize(landmarks_.size() * vertex_count);
+        distances_to_landmarks_.resize(landmarks_.size() * vertex_count);
+        pool_.ParallelFor(landmarks_.size() * 2, [&](size_t task) {
+            const size_t landmark_index = task / 2;
+            const bool is_reversed = task % 2 == 1;
+            const std::vector<Weight> distances = ComputeDistances(landmarks_[landmark_index], is_reversed);
+            auto& target = is_reversed ? distances_to_landmarks_ : distances_from_landmarks_;
+            std::copy(distances.begin(), distances.end(), target.begin() + landmark_index * vertex_count);
+        });
+    }
+
+    template <typename Weight>
+    std::vector<Weight> AltRouter<Weight>::ComputeDistances(VertexId source, bool is_reversed) const {
+        detail::SearchData<Weight> data;
+        data.Reset(graph_.GetVertexCount());
+        data.Relax(source, ZERO_WEIGHT, NO_EDGE);
+        while (!data.queue.empty()) {
+            const auto entry = data.PopQueue();
+            if (data.IsStale(entry)) {
+                continue;
+            }
+            const auto [weight, vertex] = entry;
+            // Only the distances are needed, so no edges are recorded
+            if (is_reversed) {
+                for (size_t i = reverse_offsets_[vertex]; i < reverse_offsets_[vertex + 1]; ++i) {
+                    data.Relax(reverse_sources_[i], weight + reverse_weights_[i], NO_EDGE);
+                }
+            }
+            else {
+                for (size_t arc = graph_.GetArcsBegin(vertex); arc < graph_.GetArcsEnd(vertex); ++arc) {
+                    data.Relax(graph_.GetArcTarget(arc), weight + graph_.GetArcWeight(arc), NO_EDGE);
+                }
+            }
+        }
+
+        std::vector<Weight> distances(graph_.GetVertexCount(), UNREACHABLE);
+        for (VertexId vertex = 0; vertex < distances.size(); ++vertex) {
+            if (data.IsReached(vertex)) {
+                distances[vertex] = data.weights[vertex];
+            }
+        }
+        return distances;
+    }
+
+    template <typename Weight>
+    Weight AltRouter<Weight>::ComputePotential(VertexId vertex, VertexId target) const {
+        const size_t vertex_count = graph_.GetVertexCount();
+        Weight potential = ZERO_WEIGHT;
+        for (size_t i = 0; i < landmarks_.size(); ++i) {
+            const Weight* from_landmark = distances_from_landmarks_.data() + i * vertex_count;
+            const Weight* to_landmark = distances_to_landmarks_.data() + i * vertex_count;
+            // Bounds through an unreachable landmark say nothing
+            if (from_landmark[target] != UNREACHABLE && from_landmark[vertex] != UNREACHABLE
+                && from_landmark[vertex] < from_landmark[target]) {
+                potential = std::max(potential, from_landmark[target] - from_landmark[vertex]);
+            }
+            if (to_landmark[vertex] != UNREACHABLE && to_landmark[target] != UNREACHABLE
+                && to_landmark[target] < to_landmark[vertex]) {
+                potential = std::max(potential, to_landmark[vertex] - to_landmark[target]);
+            }
+        }
+        return potential;
+    }
+
+    template <typename Weight>
+    size_t AltRouter<Weight>::GetLastSettledCount() {
+        return GetSearchData().settled_count;
+    }
+
+    template <typename Weight>
+    std::optional<typename AltRouter<Weight>::RouteInfo> AltRouter<Weight>::BuildRoute(VertexId from,
+        VertexId to) const {
+        const size_t vertex_count = graph_.GetVertexCount();
+        if (from >= vertex_count || to >= vertex_count) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+
+        AltSearchData& data = GetSearchData();
+        data.Reset(vertex_count);
+        if (data.potentials.size() < vertex_count) {
+            data.potentials.resize(vertex_count);
+        }
+
+        // The potential of a vertex is computed once, when the vertex is reached for the first time
+        auto relax = [&](VertexId vertex, Weight weight, EdgeId prev_edge) {
+            const Weight potential = data.IsReached(vertex) ? data.potentials[vertex] : ComputePotential(vertex, to);
+            if (data.Relax(vertex, weight, prev_edge, weight + potential)) {
+                data.potentials[vertex] = potential;
+            }
+        };
+
+        relax(from, ZERO_WEIGHT, NO_EDGE);
+        while (!data.queue.empty()) {
+            const auto [queue_key, vertex] = data.PopQueue();
+            const Weight weight = data.weights[vertex];
+            if (queue_key > weight + data.potentials[vertex]) {
+                continue;
+            }
+            ++data.settled_count;
+            if (vertex == to) {
+                break;
+            }
+            for (size_t arc = graph_.GetArcsBegin(vertex); arc < graph_.GetArcsEnd(vertex); ++arc) {
+                relax(graph_.GetArcTarget(arc), weight + graph_.GetArcWeight(arc), graph_.GetArcEdge(arc));
+            }
+        }
+
+        if (!data.IsReached(to)) {
+            return std::nullopt;
+        }
+        return RouteInfo{ data.weights[to], detail::ExtractPath<Weight>(graph_, data, to) };
+    }
+
+    template <typename Weight>
+    std::vector<std::optional<typename AltRouter<Weight>::RouteInfo>> AltRouter<Weight>::BuildRoutes(VertexId from,
+        const std::vector<VertexId>& targets) const {
+        return detail::BuildRoutesToTargets<Weight>(graph_, GetSearchData(), from, targets);
+    }
+
+}  // namespace graph
\ No newline at end of file
@@ -0,0 +1,429 @@
+#pragma once
+
+#include "dijkstra_router.h"
+#include "router.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+    // Contraction Hierarchies engine.
+    // Vertices are contracted one by one in the order of the edge difference heuristic; shortcuts keep
+    // the distances between the remaining vertices. A query is a bidirectional Dijkstra which only goes
+    // up the hierarchy, then every shortcut of the found path is unpacked back to the graph edges.
+    template <typename Weight>
+    class ContractionHierarchyRouter : public RouterBase<Weight> {
+    private:
+        using Graph = DirectedWeightedGraph<Weight>;
+
+    public:
+        using RouteInfo = typename RouterBase<Weight>::RouteInfo;
+
+        explicit ContractionHierarchyRouter(const Graph& graph);
+
+        std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+
+        size_t GetShortcutCount() const;
+
+    private:
+        using SearchData = detail::SearchData<Weight>;
+
+        // Edge of the hierarchy. The first graph.GetEdgeCount() edges are the graph edges with the same ids,
+        // for them first_child is the graph edge id. Shortcuts refer to the two hierarchy edges they replace.
+        struct HierarchyEdge {
+            VertexId from;
+            VertexId to;
+            Weight weight;
+            EdgeId first_child;
+            EdgeId second_child;
+        };
+
+        struct Shortcut {
+            VertexId from;
+            VertexId to;
+            Weight weight;
+            EdgeId in_edge;
+            EdgeId out_edge;
+        };
+
+        static constexpr Weight ZERO_WEIGHT{};
+        static constexpr EdgeId NO_EDGE = SearchData::NO_EDGE;
+        // Witness searches are cut after this many settled vertices, a cut search only adds a redundant shortcut.
+        // Priority estimation uses a smaller limit than the contraction itself.
+        static constexpr size_t WITNESS_SETTLED_LIMIT = 100;
+        static constexpr size_t ESTIMATE_SETTLED_LIMIT = 20;
+
+        void ContractVertices();
+        std::vector<Shortcut> FindShortcuts(VertexId vertex, size_t settled_limit, SearchData& witness_data);
+        void BuildSearchGraphs();
+        void UnpackEdge(EdgeId edge_id, std::vector<EdgeId>& edges) const;
+
+        // Best remaining edges of the vertex towards uncontracted neighbours, one per neighbour
+        std::vector<EdgeId> GetBestEdges(const std::vector<EdgeId>& edge_ids, bool outgoing) const;
+
+        const Graph& graph_;
+        std::vector<HierarchyEdge> edges_;
+        std::vector<size_t> ranks_;
+
+        // Used only while contracting
+        std::vector<std::vector<EdgeId>> out_edges_;
+        std::vector<std::vector<EdgeId>> in_edges_;
+        std::vector<bool> contracted_;
+        std::vector<bool> is_target_;
+
+        // Forward search goes along upward_edges_ of a vertex (edges to higher ranked vertices),
+        // backward search goes against downward_edges_ (edges from higher ranked vertices)
+        std::vector<size_t> upward_offsets_;
+        std::vector<EdgeId> upward_edges_;
+        std::vector<size_t> downward_offsets_;
+        std::vector<EdgeId> downward_edges_;
+    };
+
+    template <typename Weight>
+    ContractionHierarchyRouter<Weight>::ContractionHierarchyRouter(const Graph& graph)
+        : graph_(graph)
+    {
+        const size_t vertex_count = graph.GetVertexCount();
+        out_edges_.resize(vertex_count);
+        in_edges_.resize(vertex_count);
+        contracted_.assign(vertex_count, false);
+        is_target_.assign(vertex_count, false);
+        ranks_.assign(vertex_count, 0);
+
+        edges_.reserve(graph.GetEdgeCount());
+        for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+            const auto& edge = graph.GetEdge(edge_id);
+            if (edge.weight < ZERO_WEIGHT) {
+                throw std::domain_error("Edges' weights should be non-negative");
+            }
+            edges_.push_back({ edge.from, edge.to, edge.weight, edge_id, NO_EDGE });
+            if (edge.from != edge.to && !detail::IsClosedWeight(edge.weight)) {
+                out_edges_[edge.from].push_back(edge_id);
+                in_edges_[edge.to].push_back(edge_id);
+            }
+        }
+
+        ContractVertices();
+        BuildSearchGraphs();
+
+        out_edges_.clear();
+        out_edges_.shrink_to_fit();
+        in_edges_.clear();
+        in_edges_.shrink_to_fit();
+        contracted_.clear();
+        contracted_.shrink_to_fit();
+        is_target_.clear();
+        is_target_.shrink_to_fit();
+    }
+
+    template <typename Weight>
+    size_t ContractionHierarchyRouter<Weight>::GetShortcutCount() const {
+        return edges_.size() - graph_.GetEdgeCount();
+    }
+
+    template <typename Weight>
+    std::vector<EdgeId> ContractionHierarchyRouter<Weight>::GetBestEdges(const std::vector<EdgeId>& edge_ids,
+        bool outgoing) const {
+        std::vector<std::pair<VertexId, EdgeId>> neighbour_edges;
+        for (const EdgeId edge_id : edge_ids) {
+            const auto& edge = edges_[edge_id];
+            const VertexId neighbour = outgoing ? edge.to : edge.from;
+            if (!contracted_[neighbour]) {
+                neighbour_edges.push_back({ neighbour, edge_id });
+            }
+        }
+        std::sort(neighbour_edges.begin(), neighbour_edges.end(), [this](const auto& lhs, const auto& rhs) {
+            if (lhs.first != rhs.first) {
+                return lhs.first < rhs.first;
+            }
+            return edges_[lhs.second].weight < edges_[rhs.second].weight;
+        });
+
+        std::vector<EdgeId> best_edges;
+        for (size_t i = 0; i < neighbour_edges.size(); ++i) {
+            if (i == 0 || neighbour_edges[i].first != neighbour_edges[i - 1].first) {
+                best_edges.push_back(neighbour_edges[i].second);
+            }
+        }
+        return best_edges;
+    }
+
+    template <typename Weight>
+    std::vector<typename ContractionHierarchyRouter<Weight>::Shortcut>
+        ContractionHierarchyRouter<Weight>::FindShortcuts(VertexId vertex, size_t settled_limit,
+            SearchData& witness_data) {
+        const std::vector<EdgeId> in_edges = GetBestEdges(in_edges_[vertex], false);
+        const std::vector<EdgeId> out_edges = GetBestEdges(out_edges_[vertex], true);
+
+        std::vector<Shortcut> shortcuts;
+        if (in_edges.empty() || out_edges.empty()) {
+            return shortcuts;
+        }
+
+        Weight max_out_weight = ZERO_WEIGHT;
+        for (const EdgeId out_edge_id : out_edges) {
+            max_out_weight = std::max(max_out_weight, edges_[out_edge_id].weight);
+            is_target_[edges_[out_edge_id].to] = true;
+        }
+
+        for (const EdgeId in_edge_id : in_edges) {
+            const HierarchyEdge& in_edge = edges_[in_edge_id];
+            const VertexId source = in_edge.from;
+            const Weight max_weight = in_edge.weight + max_out_weight;
+
+            // Witness search: shortest paths from the source which avoid the contracted vertex
+            witness_data.Reset(contracted_.size());
+            witness_data.Relax(source, ZERO_WEIGHT, NO_EDGE);
+            size_t settled_count = 0;
+            size_t settled_target_count = 0;
+            while (!witness_data.queue.empty() && settled_count < settled_limit && settled_target_count < out_edges.size()) {
+                const auto entry = witness_data.PopQueue();
+                if (witness_data.IsStale(entry)) {
+                    continue;
+                }
+                const auto [weight, current] = entry;
+                if (max_weight < weight) {
+                    break;
+                }
+                ++settled_count;
+                if (is_target_[current]) {
+                    ++settled_target_count;
+                }
+                for (const EdgeId edge_id : out_edges_[current]) {
+                    const HierarchyEdge& edge = edges_[edge_id];
+                    if (edge.to == vertex || contracted_[edge.to]) {
+                        continue;
+                    }
+                    witness_data.Relax(edge.to, weight + edge.weight, edge_id);
+                }
+            }
+
+            for (const EdgeId out_edge_id : out_edges) {
+                const HierarchyEdge& out_edge = edges_[out_edge_id];
+                const VertexId target = out_edge.to;
+                if (target == source) {
+                    continue;
+                }
+                const Weight shortcut_weight = in_edge.weight + out_edge.weight;
+                if (witness_data.IsReached(target) && !(shortcut_weight < witness_data.weights[target])) {
+                    continue;
+                }
+                shortcuts.push_back({ source, target, shortcut_weight, in_edge_id, out_edge_id });
+            }
+        }
+
+        for (const EdgeId out_edge_id : out_edges) {
+            is_target_[edges_[out_edge_id].to] = false;
+        }
+        return shortcuts;
+    }
+
+    template <typename Weight>
+    void ContractionHierarchyRouter<Weight>::ContractVertices() {
+        const size_t vertex_count = graph_.GetVertexCount();
+        SearchData witness_data;
+        std::vector<int> contracted_neighbours(vertex_count, 0);
+
+        auto get_priority = [&](VertexId vertex) {
+            const int shortcut_count = static_cast<int>(FindShortcuts(vertex, ESTIMATE_SETTLED_LIMIT, witness_data).size());
+            const int removed_count = static_cast<int>(GetBestEdges(in_edges_[vertex], false).size()
+                + GetBestEdges(out_edges_[vertex], true).size());
+            return shortcut_count - removed_count + contracted_neighbours[vertex];
+        };
+
+        using QueueEntry = std::pair<int, VertexId>;
+        std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> queue;
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            queue.push({ get_priority(vertex), vertex });
+        }
+
+        size_t rank = 0;
+        while (!queue.empty()) {
+            const VertexId vertex = queue.top().second;
+            queue.pop();
+            if (contracted_[vertex]) {
+                continue;
+            }
+            // Lazy update: the priority may have grown since the vertex was queued
+            const int priority = get_priority(vertex);
+            if (!queue.empty() && priority > queue.top().first) {
+                queue.push({ priority, vertex });
+                continue;
+            }
+
+            for (const Shortcut& shortcut : FindShortcuts(vertex, WITNESS_SETTLED_LIMIT, witness_data)) {
+                const EdgeId edge_id = edges_.size();
+                edges_.push_back({ shortcut.from, shortcut.to, shortcut.weight, shortcut.in_edge, shortcut.out_edge });
+                out_edges_[shortcut.from].push_back(edge_id);
+                in_edges_[shortcut.to].push_back(edge_id);
+            }
+            contracted_[vertex] = true;
+            ranks_[vertex] = rank++;
+
+            // Neighbours keep only the best edge per remaining neighbour, so witness searches stay cheap
+            std::vector<VertexId> neighbours;
+            for (const EdgeId edge_id : out_edges_[vertex]) {
+                neighbours.push_back(edges_[edge_id].to);
+            }
+            for (const EdgeId edge_id : in_edges_[vertex]) {
+                neighbours.push_back(edges_[edge_id].from);
+            }
+            std::sort(neighbours.begin(), neighbours.end());
+            neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+            for (const VertexId neighbour : neighbours) {
+                if (contracted_[neighbour]) {
+                    continue;
+                }
+                ++contracted_neighbours[neighbour];
+                out_edges_[neighbour] = GetBestEdges(out_edges_[neighbour], true);
+                in_edges_[neighbour] = GetBestEdges(in_edges_[neighbour], false);
+            }
+        }
+    }
+
+    template <typename Weight>
+    void ContractionHierarchyRouter<Weight>::BuildSearchGraphs() {
+        const size_t vertex_count = graph_.GetVertexCount();
+        upward_offsets_.assign(vertex_count + 1, 0);
+        downward_offsets_.assign(vertex_count + 1, 0);
+        for (const HierarchyEdge& edge : edges_) {
+            if (ranks_[edge.from] < ranks_[edge.to]) {
+                ++upward_offsets_[edge.from + 1];
+            }
+            else if (ranks_[edge.from] > ranks_[edge.to]) {
+                ++downward_offsets_[edge.to + 1];
+            }
+        }
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            upward_offsets_[vertex + 1] += upward_offsets_[vertex];
+            downward_offsets_[vertex + 1] += downward_offsets_[vertex];
+        }
+
+        upward_edges_.resize(upward_offsets_.back());
+        downward_edges_.resize(downward_offsets_.back());
+        std::vector<size_t> upward_positions(upward_offsets_.begin(), std::prev(upward_offsets_.end()));
+        std::vector<size_t> downward_positions(downward_offsets_.begin(), std::prev(downward_offsets_.end()));
+        for (EdgeId edge_id = 0; edge_id < edges_.size(); ++edge_id) {
+            const HierarchyEdge& edge = edges_[edge_id];
+            if (ranks_[edge.from] < ranks_[edge.to]) {
+                upward_edges_[upward_positions[edge.from]++] = edge_id;
+            }
+            else if (ranks_[edge.from] > ranks_[edge.to]) {
+                downward_edges_[downward_positions[edge.to]++] = edge_id;
+            }
+        }
+    }
+
+    template <typename Weight>
+    void ContractionHierarchyRouter<Weight>::UnpackEdge(EdgeId edge_id, std::vector<EdgeId>& edges) const {
+        std::vector<EdgeId> stack{ edge_id };
+        while (!stack.empty()) {
+            const HierarchyEdge& edge = edges_[stack.back()];
+            stack.pop_back();
+            if (edge.second_child == NO_EDGE) {
+                edges.push_back(edge.first_child);
+            }
+            else {
+                stack.push_back(edge.second_child);
+                stack.push_back(edge.first_child);
+            }
+        }
+    }
+
+    template <typename Weight>
+    std::optional<typename ContractionHierarchyRouter<Weight>::RouteInfo>
+        ContractionHierarchyRouter<Weight>::BuildRoute(VertexId from, VertexId to) const {
+        const size_t vertex_count = graph_.GetVertexCount();
+        if (from >= vertex_count || to >= vertex_count) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+
+        thread_local SearchData forward_data;
+        thread_local SearchData backward_data;
+        forward_data.Reset(vertex_count);
+        backward_data.Reset(vertex_count);
+        forward_data.Relax(from, ZERO_WEIGHT, NO_EDGE);
+        backward_data.Relax(to, ZERO_WEIGHT, NO_EDGE);
+
+        std::optional<Weight> best_weight;
+        VertexId meeting_vertex = from;
+
+        while (!forward_data.queue.empty() || !backward_data.queue.empty()) {
+            const bool is_forward = backward_data.queue.empty()
+                || (!forward_data.queue.empty() && !(backward_data.queue.front().first < forward_data.queue.front().first));
+            SearchData& data = is_forward ? forward_data : backward_data;
+            const SearchData& other_data = is_forward ? backward_data : forward_data;
+
+            const auto entry = data.PopQueue();
+            if (data.IsStale(entry)) {
+                continue;
+            }
+            const auto [weight, vertex] = entry;
+            if (best_weight && !(weight < *best_weight)) {
+                // Every further vertex of this direction is not closer than the found route
+                data.queue.clear();
+                continue;
+            }
+            if (other_data.IsReached(vertex)) {
+                const Weight route_weight = weight + other_data.weights[vertex];
+                if (!best_weight || route_weight < *best_weight) {
+                    best_weight = route_weight;
+                    meeting_vertex = vertex;
+                }
+            }
+
+            // Stall on demand: a vertex reached cheaper through a higher ranked vertex is not expanded
+            const auto& stall_offsets = is_forward ? downward_offsets_ : upward_offsets_;
+            const auto& stall_edges = is_forward ? downward_edges_ : upward_edges_;
+            bool is_stalled = false;
+            for (size_t i = stall_offsets[vertex]; i < stall_offsets[vertex + 1] && !is_stalled; ++i) {
+                const HierarchyEdge& edge = edges_[stall_edges[i]];
+                const VertexId neighbour = is_forward ? edge.from : edge.to;
+                is_stalled = data.IsReached(neighbour) && data.weights[neighbour] + edge.weight < weight;
+            }
+            if (is_stalled) {
+                continue;
+            }
+
+            const auto& search_offsets = is_forward ? upward_offsets_ : downward_offsets_;
+            const auto& search_edges = is_forward ? upward_edges_ : downward_edges_;
+            for (size_t i = search_offsets[vertex]; i < search_offsets[vertex + 1]; ++i) {
+                const HierarchyEdge& edge = edges_[search_edges[i]];
+                data.Relax(is_forward ? edge.to : edge.from, weight + edge.weight, search_edges[i]);
+            }
+        }
+
+        if (!best_weight) {
+            return std::nullopt;
+        }
+
+        std::vector<EdgeId> hierarchy_edges;
+        for (EdgeId edge_id = forward_data.prev_edges[meeting_vertex]; edge_id != NO_EDGE;
+            edge_id = forward_data.prev_edges[edges_[edge_id].from])
+        {
+            hierarchy_edges.push_back(edge_id);
+        }
+        std::reverse(hierarchy_edges.begin(), hierarchy_edges.end());
+        for (EdgeId edge_id = backward_data.prev_edges[meeting_vertex]; edge_id != NO_EDGE;
+            edge_id = backward_data.prev_edges[edges_[edge_id].to])
+        {
+            hierarchy_edges.push_back(edge_id);
+        }
+
+        std::vector<EdgeId> edges;
+        for (const EdgeId edge_id : hierarchy_edges) {
+            UnpackEdge(edge_id, edges);
+        }
+
+        return RouteInfo{ *best_weight, std::move(edges) };
+    }
+
+}  // namespace graph
\ No newline at end of file
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "graph.h"
+
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace graph {
+
+    // Frozen form of DirectedWeightedGraph in compressed sparse row layout.
+    // Outgoing arcs of vertex v are the positions [offsets[v], offsets[v + 1]) of the arc arrays;
+    // targets and weights, the only data of edge relaxation, are kept in separate contiguous arrays.
+    // Everything needed only to print a route lives in the cold table indexed by EdgeId.
+    template <typename Weight>
+    class CsrGraph {
+    public:
+        struct EdgeInfo {
+            VertexId from;
+            uint32_t name_id;
+            int span_count;
+            ItemsType items_type;
+        };
+
+        CsrGraph() = default;
+        explicit CsrGraph(const DirectedWeightedGraph<Weight>& graph);
+
+        size_t GetVertexCount() const {
+            return offsets_.empty() ? 0 : offsets_.size() - 1;
+        }
+
+        size_t GetEdgeCount() const {
+            return edge_infos_.size();
+        }
+
+        size_t GetArcsBegin(VertexId vertex) const {
+            return offsets_[vertex];
+        }
+
+        size_t GetArcsEnd(VertexId vertex) const {
+            return offsets_[vertex + 1];
+        }
+
+        VertexId GetArcTarget(size_t arc) const {
+            return targets_[arc];
+        }
+
+        Weight GetArcWeight(size_t arc) const {
+            return weights_[arc];
+        }
+
+        EdgeId GetArcEdge(size_t arc) const {
+            return edge_ids_[arc];
+        }
+
+        const EdgeInfo& GetEdgeInfo(EdgeId edge_id) const {
+            return edge_infos_.at(edge_id);
+        }
+
+        std::string_view GetName(uint32_t name_id) const {
+            return names_.at(name_id);
+        }
+
+        // Keeps the frozen graph in step with a weight change of the source graph
+        void SetEdgeWeight(EdgeId edge_id, Weight weight) {
+            const VertexId from = edge_infos_.at(edge_id).from;
+            for (size_t arc = GetArcsBegin(from); arc < GetArcsEnd(from); ++arc) {
+                if (edge_ids_[arc] == edge_id) {
+                    weights_[arc] = weight;
+                    return;
+                }
+            }
+        }
+
+    private:
+        std::vector<size_t> offsets_;
+        std::vector<uint32_t> targets_;
+        std::vector<Weight> weights_;
+        std::vector<EdgeId> edge_ids_;
+
+        std::vector<EdgeInfo> edge_infos_;
+        std::vector<std::string_view> names_;
+    };
+
+    template <typename Weight>
+    CsrGraph<Weight>::CsrGraph(const DirectedWeightedGraph<Weight>& graph) {
+        const size_t vertex_count = graph.GetVertexCount();
+        const size_t edge_count = graph.GetEdgeCount();
+
+        offsets_.reserve(vertex_count + 1);
+        targets_.reserve(edge_count);
+        weights_.reserve(edge_count);
+        edge_ids_.reserve(edge_count);
+        offsets_.push_back(0);
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
+                const auto& edge = graph.GetEdge(edge_id);
+                targets_.push_back(static_cast<uint32_t>(edge.to));
+                weights_.push_back(edge.weight);
+                edge_ids_.push_back(edge_id);
+            }
+            offsets_.push_back(targets_.size());
+        }
+
+        std::unordered_map<std::string_view, uint32_t> name_ids;
+        edge_infos_.reserve(edge_count);
+        for (EdgeId edge_id = 0; edge_id < edge_count; ++edge_id) {
+            const auto& edge = graph.GetEdge(edge_id);
+            auto [name_it, is_new] = name_ids.emplace(edge.name, static_cast<uint32_t>(names_.size()));
+            if (is_new) {
+                names_.push_back(edge.name);
+            }
+            edge_infos_.push_back({ edge.from, name_it->second, edge.span_count, edge.items_type });
+        }
+    }
+
+}  // namespace graph
\ No newline at end of file
@@ -0,0 +1,271 @@
+#pragma once
+
+#include "csr_graph.h"
+#include "router.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+    namespace detail {
+
+        // Search buffers reused between queries.
+        // A vertex entry is valid only if its stamp equals the stamp of the current search,
+        // so the buffers never have to be cleared between queries.
+        template <typename Weight>
+        struct SearchData {
+            using QueueEntry = std::pair<Weight, VertexId>;
+            static constexpr EdgeId NO_EDGE = std::numeric_limits<EdgeId>::max();
+
+            std::vector<Weight> weights;
+            std::vector<EdgeId> prev_edges;
+            std::vector<uint32_t> stamps;
+            std::vector<QueueEntry> queue;
+            uint32_t stamp = 0;
+            size_t settled_count = 0;
+
+            void Reset(size_t vertex_count) {
+                if (stamps.size() < vertex_count) {
+                    weights.resize(vertex_count);
+                    prev_edges.resize(vertex_count);
+                    stamps.resize(vertex_count, 0);
+                }
+                if (++stamp == 0) {
+                    std::fill(stamps.begin(), stamps.end(), 0);
+                    stamp = 1;
+                }
+                queue.clear();
+                settled_count = 0;
+            }
+
+            bool IsReached(VertexId vertex) const {
+                return stamps[vertex] == stamp;
+            }
+
+            // Returns true if the vertex got a better weight and was queued
+            bool Relax(VertexId vertex, Weight weight, EdgeId prev_edge) {
+                return Relax(vertex, weight, prev_edge, weight);
+            }
+
+            // Goal-directed searches order the queue by queue_key instead of the weight
+            bool Relax(VertexId vertex, Weight weight, EdgeId prev_edge, Weight queue_key) {
+                if (IsClosedWeight(weight) || (IsReached(vertex) && !(weight < weights[vertex]))) {
+                    return false;
+                }
+                stamps[vertex] = stamp;
+                weights[vertex] = weight;
+                prev_edges[vertex] = prev_edge;
+                queue.push_back({ queue_key, vertex });
+                std::push_heap(queue.begin(), queue.end(), std::greater<QueueEntry>{});
+                return true;
+            }
+
+            QueueEntry PopQueue() {
+                std::pop_heap(queue.begin(), queue.end(), std::greater<QueueEntry>{});
+                const QueueEntry entry = queue.back();
+                queue.pop_back();
+                return entry;
+            }
+
+            bool IsStale(const QueueEntry& entry) const {
+                return entry.first > weights[entry.second];
+            }
+        };
+
+        // Edges of the path to a reached vertex, from the source on
+        template <typename Weight>
+        std::vector<EdgeId> ExtractPath(const CsrGraph<Weight>& graph, const SearchData<Weight>& data, VertexId to) {
+            std::vector<EdgeId> edges;
+            for (EdgeId edge_id = data.prev_edges[to]; edge_id != SearchData<Weight>::NO_EDGE;
+                edge_id = data.prev_edges[graph.GetEdgeInfo(edge_id).from])
+            {
+                edges.push_back(edge_id);
+            }
+            std::reverse(edges.begin(), edges.end());
+            return edges;
+        }
+
+        // One search from the source which stops as soon as every target is settled
+        template <typename Weight>
+        std::vector<std::optional<typename RouterBase<Weight>::RouteInfo>> BuildRoutesToTargets(const CsrGraph<Weight>& graph,
+            SearchData<Weight>& data, VertexId from, const std::vector<VertexId>& targets) {
+            const size_t vertex_count = graph.GetVertexCount();
+            if (from >= vertex_count) {
+                throw std::out_of_range("Vertex id is out of range");
+            }
+            std::vector<VertexId> pending_targets = targets;
+            std::sort(pending_targets.begin(), pending_targets.end());
+            pending_targets.erase(std::unique(pending_targets.begin(), pending_targets.end()), pending_targets.end());
+            if (!pending_targets.empty() && pending_targets.back() >= vertex_count) {
+                throw std::out_of_range("Vertex id is out of range");
+            }
+
+            data.Reset(vertex_count);
+            data.Relax(from, Weight{}, SearchData<Weight>::NO_EDGE);
+            size_t pending_count = pending_targets.size();
+            while (!data.queue.empty() && pending_count > 0) {
+                const auto entry = data.PopQueue();
+                if (data.IsStale(entry)) {
+                    continue;
+                }
+                const auto [weight, vertex] = entry;
+                ++data.settled_count;
+                if (std::binary_search(pending_targets.begin(), pending_targets.end(), vertex)) {
+                    --pending_count;
+                }
+                for (size_t arc = graph.GetArcsBegin(vertex); arc < graph.GetArcsEnd(vertex); ++arc) {
+                    data.Relax(graph.GetArcTarget(arc), weight + graph.GetArcWeight(arc), graph.GetArcEdge(arc));
+                }
+            }
+
+            std::vector<std::optional<typename RouterBase<Weight>::RouteInfo>> routes;
+            routes.reserve(targets.size());
+            for (const VertexId to : targets) {
+                if (data.IsReached(to)) {
+                    routes.push_back(typename RouterBase<Weight>::RouteInfo{ data.weights[to], ExtractPath(graph, data, to) });
+                }
+                else {
+                    routes.push_back(std::nullopt);
+                }
+            }
+            return routes;
+        }
+
+    } // namespace detail
+
+    // Vertices reachable from the source by paths not heavier than the limit, with their weights, lightest first.
+    // The search settles only these vertices, so it takes time in the size of the reachable part of the graph.
+    template <typename Weight>
+    std::vector<std::pair<VertexId, Weight>> FindVerticesWithinLimit(const DirectedWeightedGraph<Weight>& graph,
+        VertexId from, Weight limit) {
+        using SearchData = detail::SearchData<Weight>;
+        if (from >= graph.GetVertexCount()) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+        std::vector<std::pair<VertexId, Weight>> vertices;
+        if (limit < Weight{}) {
+            return vertices;
+        }
+
+        thread_local SearchData data;
+        data.Reset(graph.GetVertexCount());
+        data.Relax(from, Weight{}, SearchData::NO_EDGE);
+        while (!data.queue.empty()) {
+            const auto entry = data.PopQueue();
+            if (data.IsStale(entry)) {
+                continue;
+            }
+            const auto [weight, vertex] = entry;
+            vertices.push_back({ vertex, weight });
+            for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
+                const auto& edge = graph.GetEdge(edge_id);
+                const Weight next_weight = weight + edge.weight;
+                if (!(limit < next_weight)) {
+                    data.Relax(edge.to, next_weight, edge_id);
+                }
+            }
+        }
+        return vertices;
+    }
+
+    // On-demand engine: no precompute, every query runs Dijkstra from the source vertex over the frozen graph
+    template <typename Weight>
+    class DijkstraRouter : public RouterBase<Weight> {
+    private:
+        using Graph = CsrGraph<Weight>;
+
+    public:
+        using RouteInfo = typename RouterBase<Weight>::RouteInfo;
+
+        explicit DijkstraRouter(const Graph& graph);
+
+        std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+        std::vector<std::optional<RouteInfo>> BuildRoutes(VertexId from, const std::vector<VertexId>& targets) const override;
+
+        // Nothing is precomputed, the searches read the weights from the graph
+        bool UpdateEdgeWeights(const std::vector<std::pair<EdgeId, Weight>>& old_weights) override;
+
+        // Number of vertices settled by the last query of the calling thread
+        static size_t GetLastSettledCount();
+
+    private:
+        using SearchData = detail::SearchData<Weight>;
+
+        // Buffers are shared by all queries of the calling thread
+        static SearchData& GetSearchData() {
+            thread_local SearchData search_data;
+            return search_data;
+        }
+
+        static constexpr Weight ZERO_WEIGHT{};
+        static constexpr EdgeId NO_EDGE = SearchData::NO_EDGE;
+        const Graph& graph_;
+    };
+
+    template <typename Weight>
+    DijkstraRouter<Weight>::DijkstraRouter(const Graph& graph)
+        : graph_(graph)
+    {
+        for (size_t arc = 0; arc < graph.GetEdgeCount(); ++arc) {
+            if (graph.GetArcWeight(arc) < ZERO_WEIGHT) {
+                throw std::domain_error("Edges' weights should be non-negative");
+            }
+        }
+    }
+
+    template <typename Weight>
+    bool DijkstraRouter<Weight>::UpdateEdgeWeights(const std::vector<std::pair<EdgeId, Weight>>&) {
+        return true;
+    }
+
+    template <typename Weight>
+    size_t DijkstraRouter<Weight>::GetLastSettledCount() {
+        return GetSearchData().settled_count;
+    }
+
+    template <typename Weight>
+    std::optional<typename DijkstraRouter<Weight>::RouteInfo> DijkstraRouter<Weight>::BuildRoute(VertexId from,
+        VertexId to) const {
+        const size_t vertex_count = graph_.GetVertexCount();
+        if (from >= vertex_count || to >= vertex_count) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+
+        SearchData& data = GetSearchData();
+        data.Reset(vertex_count);
+        data.Relax(from, ZERO_WEIGHT, NO_EDGE);
+        while (!data.queue.empty()) {
+            const auto entry = data.PopQueue();
+            if (data.IsStale(entry)) {
+                continue;
+            }
+            const auto [weight, vertex] = entry;
+            ++data.settled_count;
+            if (vertex == to) {
+                break;
+            }
+            for (size_t arc = graph_.GetArcsBegin(vertex); arc < graph_.GetArcsEnd(vertex); ++arc) {
+                data.Relax(graph_.GetArcTarget(arc), weight + graph_.GetArcWeight(arc), graph_.GetArcEdge(arc));
+            }
+        }
+
+        if (!data.IsReached(to)) {
+            return std::nullopt;
+        }
+        return RouteInfo{ data.weights[to], detail::ExtractPath(graph_, data, to) };
+    }
+
+    template <typename Weight>
+    std::vector<std::optional<typename DijkstraRouter<Weight>::RouteInfo>> DijkstraRouter<Weight>::BuildRoutes(VertexId from,
+        const std::vector<VertexId>& targets) const {
+        return detail::BuildRoutesToTargets(graph_, GetSearchData(), from, targets);
+    }
+
+}  // namespace graph
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include "geo.h"
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -10,9 +11,9 @@ namespace domain {
 	struct Bus;
 
 	struct Stop {
+		uint32_t id = 0; // position in the catalogue, the stops are numbered from 0 in the order they are added
 		std::string name;
 		geo::Coordinates coordinates;
-		std::vector<Bus*> buses;
 	};
 
 	enum class BusType {
@@ -22,6 +23,7 @@ namespace domain {
 	};
 
 	struct Bus {
+		uint32_t id = 0; // position in the catalogue, the buses are numbered from 0 in the order they are added
 		std::string name;
 		std::vector<Stop*> stops;
 		BusType bus_type = BusType::DEFAULT;
@@ -1,7 +1,10 @@
 #define _USE_MATH_DEFINES
 #include "geo.h"
 
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <tuple>
 
 namespace geo {
 
@@ -13,4 +16,55 @@ namespace geo {
             * EARTH_RADIUS;
     }
 
+    std::vector<PointPair> FindClosePairs(const std::vector<Coordinates>& points, double max_distance) {
+        std::vector<PointPair> pairs;
+        if (points.empty() || !(max_distance > 0.0)) {
+            return pairs;
+        }
+        const double dr = M_PI / 180.0;
+        const double meters_per_degree = EARTH_RADIUS * dr;
+        double max_abs_lat = 0.0;
+        for (const Coordinates& point : points) {
+            max_abs_lat = std::max(max_abs_lat, std::abs(point.lat));
+        }
+        // A degree of longitude is the shortest at the latitude farthest from the equator,
+        // cells as wide as max_distance there are wide enough everywhere
+        const double lat_step = max_distance / meters_per_degree;
+        const double lng_step = max_distance / (meters_per_degree * std::max(std::cos(std::min(max_abs_lat, 89.0) * dr), 1e-6));
+
+        using Cell = std::pair<int64_t, int64_t>;
+        std::vector<std::pair<Cell, size_t>> cells;
+        cells.reserve(points.size());
+        for (size_t i = 0; i < points.size(); ++i) {
+            cells.push_back({ { static_cast<int64_t>(std::floor(points[i].lat / lat_step)),
+                static_cast<int64_t>(std::floor(points[i].lng / lng_step)) }, i });
+        }
+        std::sort(cells.begin(), cells.end());
+
+        for (const auto& [cell, i] : cells) {
+            for (int64_t lat_cell = cell.first - 1; lat_cell <= cell.first + 1; ++lat_cell) {
+                for (int64_t lng_cell = cell.second - 1; lng_cell <= cell.second + 1; ++lng_cell) {
+                    const Cell neighbour{ lat_cell, lng_cell };
+                    auto it = std::lower_bound(cells.begin(), cells.end(), std::make_pair(neighbour, size_t(0)));
+                    for (; it != cells.end() && it->first == neighbour; ++it) {
+                        const size_t j = it->second;
+                        if (j <= i) {
+                            continue;
+                        }
+                        // acos may return NaN for coinciding points
+                        double distance = ComputeDistance(points[i], points[j]);
+                        distance = std::isnan(distance) ? 0.0 : distance;
+                        if (distance <= max_distance) {
+                            pairs.push_back({ i, j, distance });
+                        }
+                    }
+                }
+            }
+        }
+        std::sort(pairs.begin(), pairs.end(), [](const PointPair& lhs, const PointPair& rhs) {
+            return std::tie(lhs.first, lhs.second) < std::tie(rhs.first, rhs.second);
+        });
+        return pairs;
+    }
+
 }  // namespace geo
\ No newline at end of file
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <cmath>
+#include <cstddef>
+#include <vector>
 
 namespace geo {
 
@@ -19,4 +21,15 @@ namespace geo {
 
     double ComputeDistance(Coordinates from, Coordinates to);
 
+    struct PointPair {
+        size_t first = 0;
+        size_t second = 0;
+        double distance = 0.0;
+    };
+
+    // Pairs first < second of the points at most max_distance meters apart, with the distances.
+    // The points are bucketed into a grid of cells at least max_distance wide and sorted by the cell,
+    // so only the points of neighbouring cells are compared: O(N log N) for points spread over the map.
+    std::vector<PointPair> FindClosePairs(const std::vector<Coordinates>& points, double max_distance);
+
 } // namespace geo
\ No newline at end of file
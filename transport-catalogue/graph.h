@@ -3,6 +3,8 @@
 #include "ranges.h"
 
 #include <cstdlib>
+#include <limits>
+#include <string_view>
 #include <vector>
 
 namespace graph {
@@ -13,7 +15,8 @@ namespace graph {
     enum class ItemsType {
         WAIT,
         BUS,
-        DEFAULT
+        DEFAULT,
+        WALK
     };
 
     template <typename Weight>
@@ -21,7 +24,7 @@ namespace graph {
         VertexId from;
         VertexId to;
         Weight weight;
-        std::string name;
+        std::string_view name; // points into the name of the stop or the bus, owned by the catalogue
         int span_count;
         ItemsType items_type = ItemsType::DEFAULT;
     };
@@ -36,6 +39,8 @@ namespace graph {
         DirectedWeightedGraph() = default;
         explicit DirectedWeightedGraph(size_t vertex_count);
         EdgeId AddEdge(const Edge<Weight>& edge);
+        void ReserveEdges(size_t edge_count);
+        void SetEdgeWeight(EdgeId edge_id, Weight weight);
 
         size_t GetVertexCount() const;
         size_t GetEdgeCount() const;
@@ -60,6 +65,16 @@ namespace graph {
         return id;
     }
 
+    template <typename Weight>
+    void DirectedWeightedGraph<Weight>::ReserveEdges(size_t edge_count) {
+        edges_.reserve(edge_count);
+    }
+
+    template <typename Weight>
+    void DirectedWeightedGraph<Weight>::SetEdgeWeight(EdgeId edge_id, Weight weight) {
+        edges_.at(edge_id).weight = weight;
+    }
+
     template <typename Weight>
     size_t DirectedWeightedGraph<Weight>::GetVertexCount() const {
         return incidence_lists_.size();
@@ -81,4 +96,36 @@ namespace graph {
         return ranges::AsRange(incidence_lists_.at(vertex));
     }
 
+    // Ids, in increasing order, of the edges left when of all the edges between the same two vertices only the lightest
+    // one is kept. Of equally light edges the one with the least id is kept, as the searches relax them in that order.
+    template <typename Weight>
+    std::vector<EdgeId> FindLightestParallelEdges(const DirectedWeightedGraph<Weight>& graph) {
+        static constexpr EdgeId NO_EDGE = std::numeric_limits<EdgeId>::max();
+        std::vector<EdgeId> lightest_edges(graph.GetVertexCount(), NO_EDGE); // by the target, for the current source
+        std::vector<char> is_kept(graph.GetEdgeCount(), 0);
+        for (VertexId vertex = 0; vertex < graph.GetVertexCount(); ++vertex) {
+            for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
+                EdgeId& lightest = lightest_edges[graph.GetEdge(edge_id).to];
+                if (lightest == NO_EDGE || graph.GetEdge(edge_id).weight < graph.GetEdge(lightest).weight) {
+                    lightest = edge_id;
+                }
+            }
+            for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
+                EdgeId& lightest = lightest_edges[graph.GetEdge(edge_id).to];
+                if (lightest != NO_EDGE) {
+                    is_kept[lightest] = 1;
+                    lightest = NO_EDGE;
+                }
+            }
+        }
+
+        std::vector<EdgeId> kept_edges;
+        for (EdgeId edge_id = 0; edge_id < is_kept.size(); ++edge_id) {
+            if (is_kept[edge_id]) {
+                kept_edges.push_back(edge_id);
+            }
+        }
+        return kept_edges;
+    }
+
 }  // namespace graph
\ No newline at end of file
@@ -58,7 +58,7 @@ namespace json_reader {
 		for (auto& stop : dict.at("stops").AsArray()) {
 			stops.push_back(stop.AsString());
 		}
-		if (!is_roundtrip) {
+		if (!is_roundtrip && !stops.empty()) {
 			stops.insert(stops.end(), std::next(stops.rbegin()), stops.rend());
 		}
 		return request_handler::BusStat{ bus_name, stops, is_roundtrip };
@@ -119,6 +119,94 @@ namespace json_reader {
 		return map_renderer::MapRenderer(std::move(render_settings));
 	}
 
+	transport_router::RoutingSettings JsonReader::GetRoutingSettingsFromRequest(const json::Dict& dict) const {
+		transport_router::RoutingSettings routing_settings;
+		routing_settings.bus_wait_time = dict.at("bus_wait_time").AsInt();
+		routing_settings.bus_velocity = dict.at("bus_velocity").AsDouble();
+		if (dict.count("router")) {
+			const std::string& router_type = dict.at("router").AsString();
+			if (router_type == "all_pairs") {
+				routing_settings.router_type = transport_router::RouterType::ALL_PAIRS;
+			}
+			else if (router_type == "dijkstra") {
+				routing_settings.router_type = transport_router::RouterType::DIJKSTRA;
+			}
+			else if (router_type == "contraction_hierarchy") {
+				routing_settings.router_type = transport_router::RouterType::CONTRACTION_HIERARCHY;
+			}
+			else if (router_type == "alt") {
+				routing_settings.router_type = transport_router::RouterType::ALT;
+			}
+			else if (router_type == "raptor") {
+				routing_settings.router_type = transport_router::RouterType::RAPTOR;
+			}
+			else if (router_type == "partition") {
+				routing_settings.router_type = transport_router::RouterType::PARTITION;
+			}
+			else if (router_type == "auto") {
+				routing_settings.router_type = transport_router::RouterType::AUTO;
+			}
+			else {
+				throw std::invalid_argument("Unknown router type: " + router_type);
+			}
+		}
+		if (dict.count("graph_model")) {
+			const std::string& graph_model = dict.at("graph_model").AsString();
+			if (graph_model == "stop_pairs") {
+				routing_settings.graph_model = transport_router::GraphModel::STOP_PAIRS;
+			}
+			else if (graph_model == "riding") {
+				routing_settings.graph_model = transport_router::GraphModel::RIDING;
+			}
+			else if (graph_model == "collapsed") {
+				routing_settings.graph_model = transport_router::GraphModel::COLLAPSED;
+			}
+			else {
+				throw std::invalid_argument("Unknown graph model: " + graph_model);
+			}
+		}
+		if (dict.count("compact_routing_tables")) {
+			routing_settings.use_compact_tables = dict.at("compact_routing_tables").AsBool();
+		}
+		if (dict.count("fixed_point_routing_tables")) {
+			routing_settings.use_fixed_point_tables = dict.at("fixed_point_routing_tables").AsBool();
+		}
+		if (dict.count("routing_cache_file")) {
+			routing_settings.cache_path = dict.at("routing_cache_file").AsString();
+		}
+		if (dict.count("landmark_count")) {
+			routing_settings.landmark_count = dict.at("landmark_count").AsInt();
+		}
+		if (dict.count("partition_cell_size")) {
+			routing_settings.partition_cell_size = dict.at("partition_cell_size").AsInt();
+		}
+		if (dict.count("hilbert_vertex_order")) {
+			routing_settings.use_hilbert_order = dict.at("hilbert_vertex_order").AsBool();
+		}
+		if (dict.count("walk_radius")) {
+			routing_settings.walk_radius = dict.at("walk_radius").AsDouble();
+		}
+		if (dict.count("walk_velocity")) {
+			routing_settings.walk_velocity = dict.at("walk_velocity").AsDouble();
+		}
+		if (dict.count("memory_budget_mb")) {
+			routing_settings.memory_budget = static_cast<size_t>(dict.at("memory_budget_mb").AsDouble() * 1024 * 1024);
+		}
+		if (dict.count("precompute_time_budget")) {
+			routing_settings.precompute_time_budget = dict.at("precompute_time_budget").AsDouble();
+		}
+		if (dict.count("all_pairs_seconds_per_step")) {
+			routing_settings.all_pairs_seconds_per_step = dict.at("all_pairs_seconds_per_step").AsDouble();
+		}
+		if (dict.count("log_router_choice")) {
+			routing_settings.log_router_choice = dict.at("log_router_choice").AsBool();
+		}
+		if (dict.count("prune_parallel_edges")) {
+			routing_settings.prune_parallel_edges = dict.at("prune_parallel_edges").AsBool();
+		}
+		return routing_settings;
+	}
+
 	void JsonReader::FillTransportCatalogue(transport_catalogue::TransportCatalogue& catalogue) {
 		json::Array base_requests = GetBaseRequests().AsArray();
 
@@ -139,9 +227,9 @@ namespace json_reader {
 				request_handler::BusStat bus_to_add = GetBusFromRequest(request.AsMap());
 				bus_to_add.is_roundtrip == true ? catalogue.AddBus(bus_to_add.name, domain::BusType::CIRCULAR) : catalogue.AddBus(bus_to_add.name, domain::BusType::LINEAR);
 				catalogue.AddStopToBus(bus_to_add.stops, bus_to_add.name);
-				catalogue.AddBusToStop(bus_to_add.stops, bus_to_add.name);
 			}
 		}
+		catalogue.Finalize();
 	}
 
 	json::Node JsonReader::BuildStopRequest(const json::Dict& dict, const transport_catalogue::TransportCatalogue& catalogue) const {
@@ -159,7 +247,7 @@ namespace json_reader {
 		}
 		else {
 			json::Array buses;
-			std::vector<std::string> unique_buses = transport_catalogue::detail::GetSortedUniqueBuses(stop);
+			std::vector<std::string> unique_buses = transport_catalogue::detail::GetSortedUniqueBuses(catalogue, stop);
 			for (auto& bus_name : unique_buses) {
 				buses.push_back(bus_name);
 			}
@@ -188,17 +276,14 @@ namespace json_reader {
 				.Build();
 		}
 		else {
-			auto curvature = transport_catalogue::detail::CalculateRouteCurvature(catalogue, bus);
-			auto route_length = transport_catalogue::detail::CalculateRouteRoadLength(catalogue, bus);
-			auto stop_count = transport_catalogue::detail::CalculateStops(bus);
-			auto unique_stop_count = transport_catalogue::detail::CalculateUniqueStops(bus);
+			const transport_catalogue::BusStats stats = catalogue.GetBusStats(bus);
 			answer =
 				json::Builder{}
 				.StartDict()
-				.Key("curvature").Value(curvature)
-				.Key("route_length").Value(route_length)
-				.Key("stop_count").Value(stop_count)
-				.Key("unique_stop_count").Value(unique_stop_count)
+				.Key("curvature").Value(stats.curvature)
+				.Key("route_length").Value(stats.route_length)
+				.Key("stop_count").Value(stats.stop_count)
+				.Key("unique_stop_count").Value(stats.unique_stop_count)
 				.Key("request_id").Value(request_id)
 				.EndDict()
 				.Build();
@@ -239,31 +324,8 @@ namespace json_reader {
 				.Build();
 		}
 		else {
-			json::Array items;
-			double total_time = 0.0;
-			for (auto& edge_id : optimal_route.value().edges) {
-				const auto& edge = transport_router.GetGraph().GetEdge(edge_id);
-				total_time += edge.weight;
-				if (edge.items_type == graph::ItemsType::WAIT) {
-					items.emplace_back(json::Node(json::Builder{}
-						.StartDict()
-						.Key("stop_name").Value(edge.name)
-						.Key("time").Value(edge.weight)
-						.Key("type").Value("Wait")
-						.EndDict()
-						.Build()));
-				}
-				if (edge.items_type == graph::ItemsType::BUS) {
-					items.emplace_back(json::Node(json::Builder{}
-						.StartDict()
-						.Key("bus").Value(edge.name)
-						.Key("span_count").Value(edge.span_count)
-						.Key("time").Value(edge.weight)
-						.Key("type").Value("Bus")
-						.EndDict()
-						.Build()));
-				}
-			}
+			json::Array items = BuildRouteItems(optimal_route.value());
+			double total_time = optimal_route.value().total_time;
 			answer = 
 				json::Builder{}
 				.StartDict()
@@ -276,13 +338,171 @@ namespace json_reader {
 		return answer;
 	}
 
-	void JsonReader::PrintStat(const transport_catalogue::TransportCatalogue& catalogue) const {
+	json::Node JsonReader::BuildRouteMatrixRequest(const json::Dict& dict, const transport_catalogue::TransportCatalogue& catalogue,
+		const transport_router::TransportRouter& transport_router) const {
+		json::Node answer;
+		int request_id = dict.at("id").AsInt();
+		bool with_items = dict.count("with_items") && dict.at("with_items").AsBool();
+		std::vector<std::string_view> stops_from;
+		std::vector<std::string_view> stops_to;
+		bool is_found = true;
+		for (auto& stop : dict.at("from").AsArray()) {
+			stops_from.push_back(stop.AsString());
+			is_found = is_found && catalogue.FindStop(stop.AsString()) != nullptr;
+		}
+		for (auto& stop : dict.at("to").AsArray()) {
+			stops_to.push_back(stop.AsString());
+			is_found = is_found && catalogue.FindStop(stop.AsString()) != nullptr;
+		}
+		if (!is_found) {
+			answer =
+				json::Builder{}
+				.StartDict()
+				.Key("request_id").Value(request_id)
+				.Key("error_message").Value("not found")
+				.EndDict()
+				.Build();
+			return answer;
+		}
 
-		transport_router::RoutingSettings routing_settings{ GetRoutingSettings().AsMap().at("bus_wait_time").AsInt(), GetRoutingSettings().AsMap().at("bus_velocity").AsDouble() };
-		transport_router::TransportRouter transport_router(routing_settings, catalogue);
+		// Unreachable pairs are null in both matrices
+		json::Array total_times;
+		json::Array items;
+		for (auto& row : transport_router.CalculateRouteMatrix(stops_from, stops_to)) {
+			json::Array row_times;
+			json::Array row_items;
+			for (auto& route : row) {
+				if (!route.has_value()) {
+					row_times.emplace_back(nullptr);
+					row_items.emplace_back(nullptr);
+					continue;
+				}
+				row_times.emplace_back(route.value().total_time);
+				if (with_items) {
+					row_items.emplace_back(BuildRouteItems(route.value()));
+				}
+			}
+			total_times.emplace_back(std::move(row_times));
+			items.emplace_back(std::move(row_items));
+		}
+		json::Builder builder;
+		builder
+			.StartDict()
+			.Key("request_id").Value(request_id)
+			.Key("total_times").Value(std::move(total_times));
+		if (with_items) {
+			builder.Key("items").Value(std::move(items));
+		}
+		answer =
+			builder
+			.EndDict()
+			.Build();
+		return answer;
+	}
+
+	json::Node JsonReader::BuildIsochroneRequest(const json::Dict& dict, const transport_catalogue::TransportCatalogue& catalogue,
+		const transport_router::TransportRouter& transport_router) const {
+		int request_id = dict.at("id").AsInt();
+		const std::string& stop_from = dict.at("from").AsString();
+		if (catalogue.FindStop(stop_from) == nullptr) {
+			return json::Builder{}
+				.StartDict()
+				.Key("request_id").Value(request_id)
+				.Key("error_message").Value("not found")
+				.EndDict()
+				.Build();
+		}
+		json::Array stops;
+		for (const auto& stop : transport_router.CalculateReachableStops(stop_from, dict.at("time_limit").AsDouble())) {
+			stops.emplace_back(json::Node(json::Builder{}
+				.StartDict()
+				.Key("stop_name").Value(std::string(stop.name))
+				.Key("time").Value(stop.time)
+				.EndDict()
+				.Build()));
+		}
+		return json::Builder{}
+			.StartDict()
+			.Key("request_id").Value(request_id)
+			.Key("stops").Value(std::move(stops))
+			.EndDict()
+			.Build();
+	}
+
+	json::Node JsonReader::BuildRoutingGraphRequest(const json::Dict& dict, const transport_router::TransportRouter& transport_router) const {
+		const transport_router::GraphStats stats = transport_router.GetGraphStats();
+		return json::Builder{}
+			.StartDict()
+			.Key("request_id").Value(dict.at("id").AsInt())
+			.Key("vertex_count").Value(static_cast<int>(stats.vertex_count))
+			.Key("edge_count").Value(static_cast<int>(stats.edge_count))
+			.Key("pruned_edge_count").Value(static_cast<int>(stats.pruned_edge_count))
+			.EndDict()
+			.Build();
+	}
+
+	json::Array JsonReader::BuildRouteItems(const transport_router::Route& route) const {
+		json::Array items;
+		for (auto& item : route.items) {
+			if (item.type == graph::ItemsType::WAIT) {
+				items.emplace_back(json::Node(json::Builder{}
+					.StartDict()
+					.Key("stop_name").Value(std::string(item.name))
+					.Key("time").Value(item.time)
+					.Key("type").Value("Wait")
+					.EndDict()
+					.Build()));
+			}
+			if (item.type == graph::ItemsType::BUS) {
+				items.emplace_back(json::Node(json::Builder{}
+					.StartDict()
+					.Key("bus").Value(std::string(item.name))
+					.Key("span_count").Value(item.span_count)
+					.Key("time").Value(item.time)
+					.Key("type").Value("Bus")
+					.EndDict()
+					.Build()));
+			}
+			if (item.type == graph::ItemsType::WALK) {
+				items.emplace_back(json::Node(json::Builder{}
+					.StartDict()
+					.Key("from").Value(std::string(item.name))
+					.Key("time").Value(item.time)
+					.Key("to").Value(std::string(item.walk_to))
+					.Key("type").Value("Walk")
+					.EndDict()
+					.Build()));
+			}
+		}
+		return items;
+	}
+
+	void JsonReader::PrintStat(const transport_catalogue::TransportCatalogue& catalogue) const {
 
 		json::Array stat_to_print;
 		json::Array stat_requests = GetStatRequests().AsArray();
+
+		// The router is built only for a batch with routing requests, in the background while the other requests
+		// are answered; the first routing request waits for it
+		const bool has_routing_requests = std::any_of(stat_requests.begin(), stat_requests.end(), [](const json::Node& request) {
+			const std::string& type = request.AsMap().at("type").AsString();
+			return type == "Route" || type == "RouteMatrix" || type == "Isochrone" || type == "RoutingGraph";
+		});
+		std::future<std::unique_ptr<transport_router::TransportRouter>> router_future;
+		if (has_routing_requests) {
+			transport_router::RoutingSettings routing_settings = GetRoutingSettingsFromRequest(GetRoutingSettings().AsMap());
+			router_future = std::async(std::launch::async, [routing_settings, &catalogue]() {
+				return std::make_unique<transport_router::TransportRouter>(routing_settings, catalogue);
+			});
+		}
+		std::unique_ptr<transport_router::TransportRouter> router;
+		auto get_router = [&router, &router_future]() -> const transport_router::TransportRouter& {
+			if (!router) {
+				router = router_future.get();
+			}
+			return *router;
+		};
+
 		for (auto& request : stat_requests) {
 			if (request.AsMap().at("type").AsString() == "Stop") {
 				stat_to_print.push_back(BuildStopRequest(request.AsMap(), catalogue).AsMap());
@@ -296,7 +516,16 @@ namespace json_reader {
 				stat_to_print.push_back(BuildMapRequest(request.AsMap(), catalogue, map_renderer).AsMap());
 			}
 			if (request.AsMap().at("type").AsString() == "Route") {
-				stat_to_print.push_back(BuildRouteRequest(request.AsMap(), transport_router).AsMap());
+				stat_to_print.push_back(BuildRouteRequest(request.AsMap(), get_router()).AsMap());
+			}
+			if (request.AsMap().at("type").AsString() == "RouteMatrix") {
+				stat_to_print.push_back(BuildRouteMatrixRequest(request.AsMap(), catalogue, get_router()).AsMap());
+			}
+			if (request.AsMap().at("type").AsString() == "Isochrone") {
+				stat_to_print.push_back(BuildIsochroneRequest(request.AsMap(), catalogue, get_router()).AsMap());
+			}
+			if (request.AsMap().at("type").AsString() == "RoutingGraph") {
+				stat_to_print.push_back(BuildRoutingGraphRequest(request.AsMap(), get_router()).AsMap());
 			}
 		}
 		json::Print(json::Document{ stat_to_print }, std::cout);
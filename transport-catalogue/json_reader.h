@@ -7,7 +7,10 @@
 #include "transport_catalogue.h"
 #include "transport_router.h"
 
+#include <algorithm>
+#include <future>
 #include <map>
+#include <memory>
 #include <sstream>
 
 namespace json_reader {
@@ -29,6 +32,7 @@ namespace json_reader {
 		request_handler::BusStat GetBusFromRequest(const json::Dict& dict) const;
 
 		map_renderer::MapRenderer GetMapRenderer(const json::Dict& dict) const;
+		transport_router::RoutingSettings GetRoutingSettingsFromRequest(const json::Dict& dict) const;
 
 		void FillTransportCatalogue(transport_catalogue::TransportCatalogue& catalogue);
 
@@ -36,6 +40,11 @@ namespace json_reader {
 		json::Node BuildBusRequest(const json::Dict& dict, const transport_catalogue::TransportCatalogue& catalogue) const;
 		json::Node BuildMapRequest(const json::Dict& dict, const transport_catalogue::TransportCatalogue& catalogue, const map_renderer::MapRenderer& map_renderer) const;
 		json::Node BuildRouteRequest(const json::Dict& dict, const transport_router::TransportRouter& transport_router) const;
+		json::Node BuildRouteMatrixRequest(const json::Dict& dict, const transport_catalogue::TransportCatalogue& catalogue, const transport_router::TransportRouter& transport_router) const;
+		json::Node BuildIsochroneRequest(const json::Dict& dict, const transport_catalogue::TransportCatalogue& catalogue, const transport_router::TransportRouter& transport_router) const;
+		json::Node BuildRoutingGraphRequest(const json::Dict& dict, const transport_router::TransportRouter& transport_router) const;
+
+		json::Array BuildRouteItems(const transport_router::Route& route) const;
 
 		void PrintStat(const transport_catalogue::TransportCatalogue& catalogue) const;
 
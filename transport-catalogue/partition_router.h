@@ -0,0 +1,427 @@
+#pragma once
+
+#include "csr_graph.h"
+#include "dijkstra_router.h"
+#include "router.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+    // Multi-level overlay engine.
+    // The vertices are split into cells, every cell of a level being a union of cells of the level below.
+    // A vertex with an edge from another cell of a level is an entry of its cell, one with an edge to another cell
+    // is an exit, and the distances inside every cell from its entries to its exits are precomputed as overlay edges.
+    // A query is Dijkstra over the graph edges only in the cells of the source and the target; elsewhere it takes
+    // the overlay of the highest level which separates a vertex from both of them. Overlay edges of the found path
+    // are unpacked by searches inside their cells. A weight change recomputes only the cells containing the edge.
+    template <typename Weight>
+    class PartitionRouter : public RouterBase<Weight> {
+    private:
+        using Graph = CsrGraph<Weight>;
+
+    public:
+        using RouteInfo = typename RouterBase<Weight>::RouteInfo;
+
+        // vertex_cells[level][vertex] is the cell of the vertex at the level, the finest level first.
+        // Vertices in one cell of a level have to be in one cell of every higher level.
+        // The cells are customized on the pool, which has to outlive the router.
+        PartitionRouter(const Graph& graph, std::vector<std::vector<uint32_t>> vertex_cells, thread_pool::ThreadPool& pool);
+
+        std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+
+        // Recomputes the cliques of the cells which contain a changed edge, from the finest level up
+        bool UpdateEdgeWeights(const std::vector<std::pair<EdgeId, Weight>>& old_weights) override;
+
+        size_t GetLevelCount() const;
+
+        // Overlay edges of all the cells of the level
+        size_t GetOverlayEdgeCount(size_t level) const;
+
+        // Number of vertices settled by the last query of the calling thread
+        static size_t GetLastSettledCount();
+
+    private:
+        // Some of the vertices of every cell of a level, grouped by the cell in the order of the ids
+        struct CellVertices {
+            std::vector<size_t> offsets; // the ones of a cell are [offsets[cell], offsets[cell + 1])
+            std::vector<VertexId> vertices;
+            std::vector<uint32_t> indices; // position of a vertex among the ones of its cell, NO_INDEX if it is not one
+
+            size_t GetCount(uint32_t cell) const {
+                return offsets[cell + 1] - offsets[cell];
+            }
+        };
+
+        // Cells of one level with the distances inside every cell from its entries to its exits
+        struct Level {
+            std::vector<uint32_t> vertex_cells;
+            size_t cell_count = 0;
+            CellVertices entries;
+            CellVertices exits;
+            std::vector<size_t> clique_offsets; // matrix of a cell, a row for every entry and a column for every exit
+            std::vector<Weight> clique_weights;
+        };
+
+        // An overlay edge is kept on the path as its level and its ends, a graph edge as its id at level 0
+        struct OverlaySearchData : detail::SearchData<Weight> {
+            std::vector<VertexId> prev_vertices;
+            std::vector<uint8_t> prev_levels;
+        };
+
+        // The query uses the data of level 0, searches inside the cells of a level the data of that level,
+        // so an overlay edge is unpacked while the search which has found it is still being read
+        static OverlaySearchData& GetSearchData(size_t level) {
+            thread_local std::deque<OverlaySearchData> search_data;
+            while (search_data.size() <= level) {
+                search_data.emplace_back();
+            }
+            return search_data[level];
+        }
+
+        void BuildLevels(std::vector<std::vector<uint32_t>> vertex_cells);
+        static CellVertices GroupByCell(const Level& level, const std::vector<char>& is_selected);
+        void CustomizeCells(size_t level, const std::vector<uint32_t>& cells);
+        void CustomizeCell(size_t level, uint32_t cell);
+
+        void Relax(OverlaySearchData& data, VertexId vertex, Weight weight, VertexId prev_vertex, EdgeId prev_edge,
+            size_t prev_level) const;
+
+        // Calls relax(target, arc_weight, edge_id, arc_level) for the arcs of the vertex at the level: the graph edges
+        // at level 0, otherwise the graph edges leaving the vertex's cell and the overlay edges of an entry to the exits
+        template <typename ArcRelax>
+        void ForEachArc(VertexId vertex, size_t level, ArcRelax&& relax) const;
+
+        // Dijkstra from the source over the arcs of level - 1 which stay in the source's cell of the level,
+        // until target_count vertices accepted by is_target are settled
+        template <typename IsTarget>
+        void SearchCell(OverlaySearchData& data, size_t level, VertexId source, size_t target_count, IsTarget&& is_target) const;
+
+        // Graph edges of the path to a reached vertex with every overlay edge on it unpacked
+        std::vector<EdgeId> ExtractPath(const OverlaySearchData& data, VertexId to) const;
+
+        static constexpr Weight ZERO_WEIGHT{};
+        static constexpr Weight UNREACHABLE = std::numeric_limits<Weight>::infinity();
+        static constexpr EdgeId NO_EDGE = detail::SearchData<Weight>::NO_EDGE;
+        static constexpr uint32_t NO_INDEX = std::numeric_limits<uint32_t>::max();
+
+        const Graph& graph_;
+        thread_pool::ThreadPool& pool_;
+        std::vector<Level> levels_; // levels_[level - 1], level 0 is the graph itself
+    };
+
+    template <typename Weight>
+    PartitionRouter<Weight>::PartitionRouter(const Graph& graph, std::vector<std::vector<uint32_t>> vertex_cells,
+        thread_pool::ThreadPool& pool)
+        : graph_(graph)
+        , pool_(pool)
+    {
+        for (size_t arc = 0; arc < graph.GetEdgeCount(); ++arc) {
+            if (graph.GetArcWeight(arc) < ZERO_WEIGHT) {
+                throw std::domain_error("Edges' weights should be non-negative");
+            }
+        }
+        if (vertex_cells.size() >= std::numeric_limits<uint8_t>::max()) {
+            throw std::invalid_argument("Too many partition levels");
+        }
+        BuildLevels(std::move(vertex_cells));
+
+        for (size_t level = 1; level <= levels_.size(); ++level) {
+            std::vector<uint32_t> cells(levels_[level - 1].cell_count);
+            for (uint32_t cell = 0; cell < cells.size(); ++cell) {
+                cells[cell] = cell;
+            }
+            CustomizeCells(level, cells);
+        }
+    }
+
+    template <typename Weight>
+    void PartitionRouter<Weight>::BuildLevels(std::vector<std::vector<uint32_t>> vertex_cells) {
+        const size_t vertex_count = graph_.GetVertexCount();
+        levels_.resize(vertex_cells.size());
+        for (size_t i = 0; i < vertex_cells.size(); ++i) {
+            if (vertex_cells[i].size() != vertex_count) {
+                throw std::invalid_argument("Every vertex should have a cell at every level");
+            }
+            levels_[i].vertex_cells = std::move(vertex_cells[i]);
+        }
+
+        for (size_t i = 0; i < levels_.size(); ++i) {
+            Level& level = levels_[i];
+            level.cell_count = vertex_count == 0 ? 0
+                : *std::max_element(level.vertex_cells.begin(), level.vertex_cells.end()) + size_t(1);
+            if (i > 0) {
+                std::vector<uint32_t> parent_cells(levels_[i - 1].cell_count, NO_INDEX);
+                for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+                    uint32_t& parent = parent_cells[levels_[i - 1].vertex_cells[vertex]];
+                    if (parent != NO_INDEX && parent != level.vertex_cells[vertex]) {
+                        throw std::invalid_argument("Cells of a level should be unions of cells of the level below");
+                    }
+                    parent = level.vertex_cells[vertex];
+                }
+            }
+
+            std::vector<char> is_entry(vertex_count, 0);
+            std::vector<char> is_exit(vertex_count, 0);
+            for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+                for (size_t arc = graph_.GetArcsBegin(vertex); arc < graph_.GetArcsEnd(vertex); ++arc) {
+                    const VertexId target = graph_.GetArcTarget(arc);
+                    if (level.vertex_cells[vertex] != level.vertex_cells[target]) {
+                        is_exit[vertex] = 1;
+                        is_entry[target] = 1;
+                    }
+                }
+            }
+            level.entries = GroupByCell(level, is_entry);
+            level.exits = GroupByCell(level, is_exit);
+
+            level.clique_offsets.assign(level.cell_count + 1, 0);
+            for (uint32_t cell = 0; cell < level.cell_count; ++cell) {
+                level.clique_offsets[cell + 1] = level.clique_offsets[cell] + level.entries.GetCount(cell) * level.exits.GetCount(cell);
+            }
+            level.clique_weights.assign(level.clique_offsets.back(), UNREACHABLE);
+        }
+    }
+
+    template <typename Weight>
+    typename PartitionRouter<Weight>::CellVertices PartitionRouter<Weight>::GroupByCell(const Level& level,
+        const std::vector<char>& is_selected) {
+        CellVertices cell_vertices;
+        cell_vertices.offsets.assign(level.cell_count + 1, 0);
+        for (VertexId vertex = 0; vertex < is_selected.size(); ++vertex) {
+            if (is_selected[vertex]) {
+                ++cell_vertices.offsets[level.vertex_cells[vertex] + 1];
+            }
+        }
+        for (size_t cell = 0; cell < level.cell_count; ++cell) {
+            cell_vertices.offsets[cell + 1] += cell_vertices.offsets[cell];
+        }
+        cell_vertices.vertices.resize(cell_vertices.offsets.back());
+        cell_vertices.indices.assign(is_selected.size(), NO_INDEX);
+        std::vector<size_t> positions(cell_vertices.offsets.begin(), std::prev(cell_vertices.offsets.end()));
+        for (VertexId vertex = 0; vertex < is_selected.size(); ++vertex) {
+            if (is_selected[vertex]) {
+                const uint32_t cell = level.vertex_cells[vertex];
+                cell_vertices.indices[vertex] = static_cast<uint32_t>(positions[cell] - cell_vertices.offsets[cell]);
+                cell_vertices.vertices[positions[cell]++] = vertex;
+            }
+        }
+        return cell_vertices;
+    }
+
+    template <typename Weight>
+    void PartitionRouter<Weight>::CustomizeCells(size_t level, const std::vector<uint32_t>& cells) {
+        pool_.ParallelFor(cells.size(), [&](size_t i) {
+            CustomizeCell(level, cells[i]);
+        });
+    }
+
+    template <typename Weight>
+    void PartitionRouter<Weight>::CustomizeCell(size_t level, uint32_t cell) {
+        Level& overlay = levels_[level - 1];
+        const VertexId* entries = overlay.entries.vertices.data() + overlay.entries.offsets[cell];
+        const VertexId* exits = overlay.exits.vertices.data() + overlay.exits.offsets[cell];
+        const size_t entry_count = overlay.entries.GetCount(cell);
+        const size_t exit_count = overlay.exits.GetCount(cell);
+        Weight* matrix = overlay.clique_weights.data() + overlay.clique_offsets[cell];
+        OverlaySearchData& data = GetSearchData(level);
+        for (size_t i = 0; i < entry_count; ++i) {
+            SearchCell(data, level, entries[i], exit_count, [&overlay](VertexId vertex) {
+                return overlay.exits.indices[vertex] != NO_INDEX;
+            });
+            for (size_t j = 0; j < exit_count; ++j) {
+                matrix[i * exit_count + j] = data.IsReached(exits[j]) ? data.weights[exits[j]] : UNREACHABLE;
+            }
+        }
+    }
+
+    template <typename Weight>
+    bool PartitionRouter<Weight>::UpdateEdgeWeights(const std::vector<std::pair<EdgeId, Weight>>& old_weights) {
+        // The cells containing both ends of a changed edge; at the levels where it crosses cells it is read directly
+        std::vector<std::vector<uint32_t>> changed_cells(levels_.size());
+        for (const auto& [edge_id, old_weight] : old_weights) {
+            const VertexId from = graph_.GetEdgeInfo(edge_id).from;
+            for (size_t arc = graph_.GetArcsBegin(from); arc < graph_.GetArcsEnd(from); ++arc) {
+                if (graph_.GetArcEdge(arc) != edge_id) {
+                    continue;
+                }
+                const VertexId to = graph_.GetArcTarget(arc);
+                for (size_t i = 0; i < levels_.size(); ++i) {
+                    if (levels_[i].vertex_cells[from] == levels_[i].vertex_cells[to]) {
+                        changed_cells[i].push_back(levels_[i].vertex_cells[from]);
+                    }
+                }
+            }
+        }
+        // A cell depends on the cliques of its own cells one level below, so the levels go bottom up
+        for (size_t i = 0; i < levels_.size(); ++i) {
+            std::vector<uint32_t>& cells = changed_cells[i];
+            std::sort(cells.begin(), cells.end());
+            cells.erase(std::unique(cells.begin(), cells.end()), cells.end());
+            CustomizeCells(i + 1, cells);
+        }
+        return true;
+    }
+
+    template <typename Weight>
+    void PartitionRouter<Weight>::Relax(OverlaySearchData& data, VertexId vertex, Weight weight, VertexId prev_vertex,
+        EdgeId prev_edge, size_t prev_level) const {
+        if (data.prev_vertices.size() < data.weights.size()) {
+            data.prev_vertices.resize(data.weights.size());
+            data.prev_levels.resize(data.weights.size());
+        }
+        if (data.Relax(vertex, weight, prev_edge)) {
+            data.prev_vertices[vertex] = prev_vertex;
+            data.prev_levels[vertex] = static_cast<uint8_t>(prev_level);
+        }
+    }
+
+    template <typename Weight>
+    template <typename ArcRelax>
+    void PartitionRouter<Weight>::ForEachArc(VertexId vertex, size_t level, ArcRelax&& relax) const {
+        if (level == 0) {
+            for (size_t arc = graph_.GetArcsBegin(vertex); arc < graph_.GetArcsEnd(vertex); ++arc) {
+                relax(graph_.GetArcTarget(arc), graph_.GetArcWeight(arc), graph_.GetArcEdge(arc), 0);
+            }
+            return;
+        }
+        const Level& overlay = levels_[level - 1];
+        const uint32_t cell = overlay.vertex_cells[vertex];
+        for (size_t arc = graph_.GetArcsBegin(vertex); arc < graph_.GetArcsEnd(vertex); ++arc) {
+            const VertexId target = graph_.GetArcTarget(arc);
+            if (overlay.vertex_cells[target] != cell) {
+                relax(target, graph_.GetArcWeight(arc), graph_.GetArcEdge(arc), 0);
+            }
+        }
+        const uint32_t entry_index = overlay.entries.indices[vertex];
+        if (entry_index == NO_INDEX) {
+            return;
+        }
+        const VertexId* exits = overlay.exits.vertices.data() + overlay.exits.offsets[cell];
+        const size_t exit_count = overlay.exits.GetCount(cell);
+        const Weight* row = overlay.clique_weights.data() + overlay.clique_offsets[cell] + entry_index * exit_count;
+        for (size_t i = 0; i < exit_count; ++i) {
+            relax(exits[i], row[i], NO_EDGE, level);
+        }
+    }
+
+    template <typename Weight>
+    template <typename IsTarget>
+    void PartitionRouter<Weight>::SearchCell(OverlaySearchData& data, size_t level, VertexId source, size_t target_count,
+        IsTarget&& is_target) const {
+        const std::vector<uint32_t>& vertex_cells = levels_[level - 1].vertex_cells;
+        const uint32_t cell = vertex_cells[source];
+        data.Reset(graph_.GetVertexCount());
+        Relax(data, source, ZERO_WEIGHT, source, NO_EDGE, 0);
+        while (!data.queue.empty() && target_count > 0) {
+            const auto entry = data.PopQueue();
+            if (data.IsStale(entry)) {
+                continue;
+            }
+            const auto [weight, vertex] = entry;
+            if (is_target(vertex)) {
+                --target_count;
+            }
+            ForEachArc(vertex, level - 1, [&](VertexId target, Weight arc_weight, EdgeId edge_id, size_t arc_level) {
+                if (vertex_cells[target] == cell) {
+                    Relax(data, target, weight + arc_weight, vertex, edge_id, arc_level);
+                }
+            });
+        }
+    }
+
+    template <typename Weight>
+    std::vector<EdgeId> PartitionRouter<Weight>::ExtractPath(const OverlaySearchData& data, VertexId to) const {
+        // (from, to, edge, level) of every arc of the path from the target back, the source is its own previous vertex
+        std::vector<std::tuple<VertexId, VertexId, EdgeId, size_t>> arcs;
+        for (VertexId vertex = to; data.prev_vertices[vertex] != vertex; vertex = data.prev_vertices[vertex]) {
+            arcs.push_back({ data.prev_vertices[vertex], vertex, data.prev_edges[vertex], data.prev_levels[vertex] });
+        }
+
+        std::vector<EdgeId> edges;
+        for (auto arc = arcs.rbegin(); arc != arcs.rend(); ++arc) {
+            const auto [from, target, edge_id, level] = *arc;
+            if (level == 0) {
+                edges.push_back(edge_id);
+                continue;
+            }
+            // The search over the level below inside the cell finds a path of the weight of the overlay edge
+            OverlaySearchData& cell_data = GetSearchData(level);
+            SearchCell(cell_data, level, from, 1, [target = target](VertexId vertex) {
+                return vertex == target;
+            });
+            const std::vector<EdgeId> cell_edges = ExtractPath(cell_data, target);
+            edges.insert(edges.end(), cell_edges.begin(), cell_edges.end());
+        }
+        return edges;
+    }
+
+    template <typename Weight>
+    size_t PartitionRouter<Weight>::GetLevelCount() const {
+        return levels_.size();
+    }
+
+    template <typename Weight>
+    size_t PartitionRouter<Weight>::GetOverlayEdgeCount(size_t level) const {
+        return levels_.at(level - 1).clique_weights.size();
+    }
+
+    template <typename Weight>
+    size_t PartitionRouter<Weight>::GetLastSettledCount() {
+        return GetSearchData(0).settled_count;
+    }
+
+    template <typename Weight>
+    std::optional<typename PartitionRouter<Weight>::RouteInfo> PartitionRouter<Weight>::BuildRoute(VertexId from,
+        VertexId to) const {
+        const size_t vertex_count = graph_.GetVertexCount();
+        if (from >= vertex_count || to >= vertex_count) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+
+        // The highest level at which the vertex is in neither the cell of the source nor the one of the target,
+        // 0 in the finest cells of the two
+        auto get_query_level = [&](VertexId vertex) -> size_t {
+            for (size_t level = levels_.size(); level > 0; --level) {
+                const std::vector<uint32_t>& cells = levels_[level - 1].vertex_cells;
+                if (cells[vertex] != cells[from] && cells[vertex] != cells[to]) {
+                    return level;
+                }
+            }
+            return 0;
+        };
+
+        OverlaySearchData& data = GetSearchData(0);
+        data.Reset(vertex_count);
+        Relax(data, from, ZERO_WEIGHT, from, NO_EDGE, 0);
+        while (!data.queue.empty()) {
+            const auto entry = data.PopQueue();
+            if (data.IsStale(entry)) {
+                continue;
+            }
+            const auto [weight, vertex] = entry;
+            ++data.settled_count;
+            if (vertex == to) {
+                break;
+            }
+            ForEachArc(vertex, get_query_level(vertex), [&](VertexId target, Weight arc_weight, EdgeId edge_id, size_t arc_level) {
+                Relax(data, target, weight + arc_weight, vertex, edge_id, arc_level);
+            });
+        }
+
+        if (!data.IsReached(to)) {
+            return std::nullopt;
+        }
+        return RouteInfo{ data.weights[to], ExtractPath(data, to) };
+    }
+
+}  // namespace graph
\ No newline at end of file
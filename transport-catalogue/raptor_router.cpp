@@ -0,0 +1,300 @@
+#include "raptor_router.h"
+
+#include <algorithm>
+#include <functional>
+
+namespace raptor_router {
+
+    namespace {
+
+        const uint32_t NO_POSITION = std::numeric_limits<uint32_t>::max();
+
+    } // namespace
+
+    RaptorRouter::RaptorRouter(const transport_catalogue::TransportCatalogue& catalogue, int bus_wait_time, double bus_velocity,
+        std::vector<const domain::Stop*> stops, const std::vector<const domain::Bus*>& buses,
+        const std::vector<Transfer>& transfers)
+        : catalogue_(catalogue)
+        , bus_wait_time_(static_cast<double>(bus_wait_time))
+        , meters_per_minute_(bus_velocity * (1000.0 / 60.0))
+        , stops_(std::move(stops))
+    {
+        for (uint32_t stop_id = 0; stop_id < stops_.size(); ++stop_id) {
+            stop_ids_.emplace(stops_[stop_id], stop_id);
+        }
+        is_stop_enabled_.assign(stop_ids_.size(), 1);
+
+        for (const domain::Bus* bus_ptr : buses) {
+            RoutePattern route{ bus_ptr, {}, {} };
+            route.stops.reserve(bus_ptr->stops.size());
+            for (const domain::Stop* stop : bus_ptr->stops) {
+                route.stops.push_back(stop_ids_.at(stop));
+            }
+            FillDistances(route);
+            route_ids_.emplace(bus_ptr, static_cast<uint32_t>(routes_.size()));
+            routes_.push_back(std::move(route));
+        }
+
+        stop_route_offsets_.assign(stop_ids_.size() + 1, 0);
+        for (const RoutePattern& route : routes_) {
+            for (const uint32_t stop : route.stops) {
+                ++stop_route_offsets_[stop + 1];
+            }
+        }
+        for (size_t stop = 0; stop < stop_ids_.size(); ++stop) {
+            stop_route_offsets_[stop + 1] += stop_route_offsets_[stop];
+        }
+        stop_routes_.resize(stop_route_offsets_.back());
+        std::vector<size_t> positions(stop_route_offsets_.begin(), std::prev(stop_route_offsets_.end()));
+        for (uint32_t route_id = 0; route_id < routes_.size(); ++route_id) {
+            const auto& stops = routes_[route_id].stops;
+            for (uint32_t position = 0; position < stops.size(); ++position) {
+                stop_routes_[positions[stops[position]]++] = { route_id, position };
+            }
+        }
+
+        stop_transfer_offsets_.assign(stop_ids_.size() + 1, 0);
+        for (const Transfer& transfer : transfers) {
+            ++stop_transfer_offsets_[GetStopId(transfer.from) + 1];
+        }
+        for (size_t stop = 0; stop < stop_ids_.size(); ++stop) {
+            stop_transfer_offsets_[stop + 1] += stop_transfer_offsets_[stop];
+        }
+        stop_transfers_.resize(stop_transfer_offsets_.back());
+        positions.assign(stop_transfer_offsets_.begin(), std::prev(stop_transfer_offsets_.end()));
+        for (const Transfer& transfer : transfers) {
+            stop_transfers_[positions[GetStopId(transfer.from)]++] = { GetStopId(transfer.to), transfer.walk_time };
+        }
+    }
+
+    void RaptorRouter::FillDistances(RoutePattern& route) const {
+        const auto& stops = route.bus->stops;
+        route.distances.resize(stops.size());
+        for (size_t i = 0; i < stops.size(); ++i) {
+            route.distances[i] = i == 0 ? 0.0 : route.distances[i - 1] + catalogue_.GetDistance(stops[i - 1], stops[i]);
+        }
+    }
+
+    void RaptorRouter::UpdateBus(const domain::Bus* bus) {
+        FillDistances(routes_[route_ids_.at(bus)]);
+    }
+
+    void RaptorRouter::SetStopEnabled(const domain::Stop* stop, bool is_enabled) {
+        is_stop_enabled_[GetStopId(stop)] = is_enabled;
+    }
+
+    void RaptorRouter::SetBusEnabled(const domain::Bus* bus, bool is_enabled) {
+        routes_[route_ids_.at(bus)].is_enabled = is_enabled;
+    }
+
+    uint32_t RaptorRouter::GetStopId(const domain::Stop* stop) const {
+        return stop_ids_.at(stop);
+    }
+
+    double RaptorRouter::GetRideTime(const RoutePattern& route, size_t board_index, size_t alight_index) const {
+        return (route.distances[alight_index] - route.distances[board_index]) / meters_per_minute_;
+    }
+
+    void RaptorRouter::Search(SearchData& data, uint32_t source, uint32_t target, double time_limit) const {
+        const size_t stop_count = stop_ids_.size();
+        if (data.rounds.empty()) {
+            data.rounds.emplace_back();
+        }
+        data.rounds[0].assign(stop_count, Label{});
+        data.rounds[0][source].time = 0.0;
+        data.best_times.assign(stop_count, UNREACHED);
+        data.best_times[source] = 0.0;
+        data.route_starts.assign(routes_.size(), NO_POSITION);
+        data.is_marked.assign(stop_count, 0);
+        data.queued_routes.clear();
+        data.marked_stops.assign(1, source);
+        data.is_marked[source] = 1;
+        data.round_count = 1;
+        RelaxTransfers(data, 0, target, time_limit);
+
+        for (uint32_t round = 1; !data.marked_stops.empty(); ++round) {
+            // Every route through an improved stop is scanned once, from its earliest improved stop
+            for (const uint32_t stop : data.marked_stops) {
+                data.is_marked[stop] = 0;
+                for (size_t i = stop_route_offsets_[stop]; i < stop_route_offsets_[stop + 1]; ++i) {
+                    const auto [route_id, position] = stop_routes_[i];
+                    if (!routes_[route_id].is_enabled) {
+                        continue;
+                    }
+                    if (data.route_starts[route_id] == NO_POSITION) {
+                        data.queued_routes.push_back(route_id);
+                        data.route_starts[route_id] = position;
+                    }
+                    else {
+                        data.route_starts[route_id] = std::min(data.route_starts[route_id], position);
+                    }
+                }
+            }
+            data.marked_stops.clear();
+
+            if (data.rounds.size() <= round) {
+                data.rounds.emplace_back();
+            }
+            data.rounds[round] = data.rounds[round - 1];
+            data.round_count = round + 1;
+            const std::vector<Label>& previous = data.rounds[round - 1];
+            std::vector<Label>& current = data.rounds[round];
+
+            for (const uint32_t route_id : data.queued_routes) {
+                const RoutePattern& route = routes_[route_id];
+                const uint32_t start = data.route_starts[route_id];
+                data.route_starts[route_id] = NO_POSITION;
+
+                bool is_boarded = false;
+                uint32_t board_index = 0;
+                double board_time = 0.0;
+                for (uint32_t position = start; position < route.stops.size(); ++position) {
+                    const uint32_t stop = route.stops[position];
+                    if (!is_stop_enabled_[stop]) {
+                        continue;
+                    }
+                    if (is_boarded) {
+                        const double time = board_time + GetRideTime(route, board_index, position);
+                        const double bound = target == NO_STOP ? data.best_times[stop]
+                            : std::min(data.best_times[stop], data.best_times[target]);
+                        if (time < bound && time <= time_limit) {
+                            current[stop] = Label{ time, route_id, board_index, position, round };
+                            data.best_times[stop] = time;
+                            if (!data.is_marked[stop]) {
+                                data.is_marked[stop] = 1;
+                                data.marked_stops.push_back(stop);
+                            }
+                        }
+                    }
+                    // A later boarding pays off if it is earlier than staying on the bus
+                    if (previous[stop].time != UNREACHED) {
+                        const double candidate_time = previous[stop].time + bus_wait_time_;
+                        if (!is_boarded || candidate_time < board_time + GetRideTime(route, board_index, position)) {
+                            is_boarded = true;
+                            board_index = position;
+                            board_time = candidate_time;
+                        }
+                    }
+                }
+            }
+            data.queued_routes.clear();
+            RelaxTransfers(data, round, target, time_limit);
+        }
+    }
+
+    void RaptorRouter::RelaxTransfers(SearchData& data, uint32_t round, uint32_t target, double time_limit) const {
+        if (stop_transfers_.empty()) {
+            return;
+        }
+        using QueueEntry = std::pair<double, uint32_t>;
+        std::vector<Label>& current = data.rounds[round];
+        std::vector<QueueEntry>& queue = data.walk_queue;
+        queue.clear();
+        for (const uint32_t stop : data.marked_stops) {
+            queue.push_back({ current[stop].time, stop });
+        }
+        std::make_heap(queue.begin(), queue.end(), std::greater<QueueEntry>{});
+
+        while (!queue.empty()) {
+            std::pop_heap(queue.begin(), queue.end(), std::greater<QueueEntry>{});
+            const auto [time, stop] = queue.back();
+            queue.pop_back();
+            if (time > data.best_times[stop] || !is_stop_enabled_[stop]) {
+                continue;
+            }
+            for (size_t i = stop_transfer_offsets_[stop]; i < stop_transfer_offsets_[stop + 1]; ++i) {
+                const auto [next_stop, walk_time] = stop_transfers_[i];
+                if (!is_stop_enabled_[next_stop]) {
+                    continue;
+                }
+                const double next_time = time + walk_time;
+                const double bound = target == NO_STOP ? data.best_times[next_stop]
+                    : std::min(data.best_times[next_stop], data.best_times[target]);
+                if (next_time < bound && next_time <= time_limit) {
+                    current[next_stop] = Label{ next_time, NO_ROUTE, 0, 0, round, stop };
+                    data.best_times[next_stop] = next_time;
+                    if (!data.is_marked[next_stop]) {
+                        data.is_marked[next_stop] = 1;
+                        data.marked_stops.push_back(next_stop);
+                    }
+                    queue.push_back({ next_time, next_stop });
+                    std::push_heap(queue.begin(), queue.end(), std::greater<QueueEntry>{});
+                }
+            }
+        }
+    }
+
+    std::optional<Journey> RaptorRouter::ExtractJourney(const SearchData& data, uint32_t target) const {
+        Label label = data.rounds[data.round_count - 1][target];
+        if (label.time == UNREACHED) {
+            return std::nullopt;
+        }
+        // The boarding used the arrival of the previous round and the walk an arrival of the same round,
+        // neither is changed after the round
+        Journey journey;
+        uint32_t stop = target;
+        while (label.route != NO_ROUTE || label.walk_from != NO_STOP) {
+            if (label.route == NO_ROUTE) {
+                const auto transfers_begin = stop_transfers_.begin() + stop_transfer_offsets_[label.walk_from];
+                const auto transfers_end = stop_transfers_.begin() + stop_transfer_offsets_[label.walk_from + 1];
+                const auto transfer = std::find_if(transfers_begin, transfers_end,
+                    [stop](const auto& transfer) { return transfer.first == stop; });
+                journey.legs.push_back({ nullptr, 0, 0, transfer->second, stops_[label.walk_from], stops_[stop] });
+                stop = label.walk_from;
+                label = data.rounds[label.round][stop];
+                continue;
+            }
+            const RoutePattern& route = routes_[label.route];
+            journey.legs.push_back({ route.bus, label.board_index, label.alight_index,
+                GetRideTime(route, label.board_index, label.alight_index) });
+            stop = route.stops[label.board_index];
+            label = data.rounds[label.round - 1][stop];
+        }
+        std::reverse(journey.legs.begin(), journey.legs.end());
+        return journey;
+    }
+
+    std::optional<Journey> RaptorRouter::BuildJourney(const domain::Stop* from, const domain::Stop* to) const {
+        const uint32_t source = GetStopId(from);
+        const uint32_t target = GetStopId(to);
+        SearchData& data = GetSearchData();
+        Search(data, source, target);
+        return ExtractJourney(data, target);
+    }
+
+    std::vector<std::optional<Journey>> RaptorRouter::BuildJourneys(const domain::Stop* from,
+        const std::vector<const domain::Stop*>& targets) const {
+        const uint32_t source = GetStopId(from);
+        std::vector<uint32_t> target_ids;
+        target_ids.reserve(targets.size());
+        for (const domain::Stop* target : targets) {
+            target_ids.push_back(GetStopId(target));
+        }
+
+        SearchData& data = GetSearchData();
+        Search(data, source, NO_STOP);
+        std::vector<std::optional<Journey>> journeys;
+        journeys.reserve(targets.size());
+        for (const uint32_t target : target_ids) {
+            journeys.push_back(ExtractJourney(data, target));
+        }
+        return journeys;
+    }
+
+    std::vector<std::pair<const domain::Stop*, double>> RaptorRouter::FindReachableStops(const domain::Stop* from,
+        double time_limit) const {
+        std::vector<std::pair<const domain::Stop*, double>> stops;
+        if (time_limit < 0.0) {
+            return stops;
+        }
+        SearchData& data = GetSearchData();
+        Search(data, GetStopId(from), NO_STOP, time_limit);
+        for (uint32_t stop = 0; stop < stops_.size(); ++stop) {
+            if (data.best_times[stop] != UNREACHED) {
+                stops.push_back({ stops_[stop], data.best_times[stop] });
+            }
+        }
+        return stops;
+    }
+
+} // namespace raptor_router
\ No newline at end of file
@@ -0,0 +1,134 @@
+#pragma once
+
+#include "domain.h"
+#include "transport_catalogue.h"
+
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Round-based routing straight over the bus routes of the catalogue, without the routing graph.
+// Round k finds the best arrival at every stop with exactly k boardings: the routes through the stops improved
+// in round k - 1 are scanned once from their earliest improved stop, so a round is linear in the routes' length.
+namespace raptor_router {
+
+    // Ride on a bus between two positions of bus->stops, boarded after the wait at the first one,
+    // or a walk between two stops if there is no bus
+    struct Leg {
+        const domain::Bus* bus = nullptr;
+        size_t board_index = 0;
+        size_t alight_index = 0;
+        double ride_time = 0.0; // on the bus or on foot
+        const domain::Stop* walk_from = nullptr;
+        const domain::Stop* walk_to = nullptr;
+    };
+
+    // Walk from one stop to another, possible before and after any ride
+    struct Transfer {
+        const domain::Stop* from = nullptr;
+        const domain::Stop* to = nullptr;
+        double walk_time = 0.0;
+    };
+
+    struct Journey {
+        std::vector<Leg> legs;
+    };
+
+    class RaptorRouter {
+    public:
+        // Same semantics as the routing graph: bus_wait_time minutes before every boarding, bus_velocity in km/h,
+        // any number of walks between the rides. The stops and the buses of the catalogue are numbered in the order
+        // of stops and buses.
+        RaptorRouter(const transport_catalogue::TransportCatalogue& catalogue, int bus_wait_time, double bus_velocity,
+            std::vector<const domain::Stop*> stops, const std::vector<const domain::Bus*>& buses,
+            const std::vector<Transfer>& transfers = {});
+
+        std::optional<Journey> BuildJourney(const domain::Stop* from, const domain::Stop* to) const;
+
+        // Journeys from one stop to every target, in the order of the targets, computed by a single search
+        std::vector<std::optional<Journey>> BuildJourneys(const domain::Stop* from, const std::vector<const domain::Stop*>& targets) const;
+
+        // Stops with the earliest arrival no later than time_limit, the source included, in no particular order
+        std::vector<std::pair<const domain::Stop*, double>> FindReachableStops(const domain::Stop* from, double time_limit) const;
+
+        // Re-reads the road distances along the bus from the catalogue
+        void UpdateBus(const domain::Bus* bus);
+
+        // Nobody boards or alights at a disabled stop, buses still pass it. A disabled bus is not used at all.
+        void SetStopEnabled(const domain::Stop* stop, bool is_enabled);
+        void SetBusEnabled(const domain::Bus* bus, bool is_enabled);
+
+    private:
+        static constexpr uint32_t NO_ROUTE = std::numeric_limits<uint32_t>::max();
+        static constexpr uint32_t NO_STOP = std::numeric_limits<uint32_t>::max();
+        static constexpr double UNREACHED = std::numeric_limits<double>::infinity();
+
+        struct RoutePattern {
+            const domain::Bus* bus;
+            std::vector<uint32_t> stops;
+            std::vector<double> distances; // road distance from the first stop, exact as it is a sum of integers
+            bool is_enabled = true;
+        };
+
+        // Arrival at a stop with the last leg leading to it: a ride on the route or a walk from walk_from
+        struct Label {
+            double time = UNREACHED;
+            uint32_t route = NO_ROUTE;
+            uint32_t board_index = 0;
+            uint32_t alight_index = 0;
+            uint32_t round = 0;
+            uint32_t walk_from = NO_STOP;
+        };
+
+        struct SearchData {
+            std::vector<std::vector<Label>> rounds; // grows on demand, only the first round_count are valid
+            size_t round_count = 0;
+            std::vector<double> best_times;
+            std::vector<uint32_t> route_starts;
+            std::vector<uint32_t> queued_routes;
+            std::vector<uint32_t> marked_stops;
+            std::vector<char> is_marked;
+            std::vector<std::pair<double, uint32_t>> walk_queue;
+        };
+
+        static SearchData& GetSearchData() {
+            thread_local SearchData search_data;
+            return search_data;
+        }
+
+        uint32_t GetStopId(const domain::Stop* stop) const;
+
+        double GetRideTime(const RoutePattern& route, size_t board_index, size_t alight_index) const;
+
+        void FillDistances(RoutePattern& route) const;
+
+        // Fills the rounds of the search data; arrivals not better than the target bound or later than the limit are dropped
+        void Search(SearchData& data, uint32_t source, uint32_t target, double time_limit = UNREACHED) const;
+
+        // Walks from the stops marked in the round by Dijkstra over the transfers, marking the stops reached earlier
+        void RelaxTransfers(SearchData& data, uint32_t round, uint32_t target, double time_limit) const;
+
+        std::optional<Journey> ExtractJourney(const SearchData& data, uint32_t target) const;
+
+        const transport_catalogue::TransportCatalogue& catalogue_;
+        double bus_wait_time_;
+        double meters_per_minute_;
+        std::unordered_map<const domain::Stop*, uint32_t> stop_ids_;
+        std::vector<const domain::Stop*> stops_; // by the stop id
+        std::vector<char> is_stop_enabled_;
+        std::vector<RoutePattern> routes_;
+        std::unordered_map<const domain::Bus*, uint32_t> route_ids_;
+
+        // Occurrences (route, position) of every stop in the routes
+        std::vector<size_t> stop_route_offsets_;
+        std::vector<std::pair<uint32_t, uint32_t>> stop_routes_;
+
+        // Walks (stop, time) from every stop
+        std::vector<size_t> stop_transfer_offsets_;
+        std::vector<std::pair<uint32_t, double>> stop_transfers_;
+    };
+
+} // namespace raptor_router
\ No newline at end of file
@@ -1,116 +1,727 @@
 #pragma once
 
 #include "graph.h"
+#include "thread_pool.h"
 
 #include <algorithm>
+#include <array>
 #include <cassert>
+#include <cmath>
 #include <cstdint>
+#include <functional>
 #include <iterator>
+#include <limits>
+#include <memory>
 #include <optional>
 #include <stdexcept>
+#include <type_traits>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
 namespace graph {
 
+    namespace detail {
+
+        // An edge of infinite weight is closed: it stays in the graph but no route may use it
+        template <typename Weight>
+        constexpr bool IsClosedWeight(Weight weight) {
+            if constexpr (std::numeric_limits<Weight>::has_infinity) {
+                return !(weight < std::numeric_limits<Weight>::infinity());
+            }
+            else {
+                return false;
+            }
+        }
+
+    } // namespace detail
+
+    // Arithmetic of a weight type of the all-pairs tables. Floating point weights hold the graph's weights as they are.
+    template <typename Weight, typename = void>
+    struct WeightTraits {
+        static constexpr Weight INFINITE_WEIGHT = std::numeric_limits<Weight>::infinity();
+
+        template <typename Real>
+        static Weight FromReal(Real weight) {
+            return static_cast<Weight>(weight);
+        }
+    };
+
+    // Integer weights are fixed-point: the graph's weight times SCALE, rounded, i.e. milliseconds for weights
+    // in minutes. Unreachable is a quarter of the range, so the sum of two table weights never overflows
+    // and stays in the signed range for the SIMD comparisons.
     template <typename Weight>
-    class Router {
-    private:
-        using Graph = DirectedWeightedGraph<Weight>;
+    struct WeightTraits<Weight, std::enable_if_t<std::is_integral_v<Weight>>> {
+        static constexpr Weight INFINITE_WEIGHT = std::numeric_limits<Weight>::max() / 4;
+        // Routes not shorter than INFINITE_WEIGHT / SCALE do not fit: for uint32_t it is 17895 minutes, about 298 hours.
+        // Router checks its tables for such routes, see Router::IsTableInRange.
+        static constexpr double SCALE = 60000.0;
 
-    public:
-        explicit Router(const Graph& graph);
+        template <typename Real>
+        static Weight FromReal(Real weight) {
+            const Real scaled = std::round(weight * SCALE);
+            return scaled < static_cast<Real>(INFINITE_WEIGHT) ? static_cast<Weight>(scaled) : INFINITE_WEIGHT;
+        }
+    };
 
+    // Common query interface of all routing engines over DirectedWeightedGraph
+    template <typename Weight>
+    class RouterBase {
+    public:
         struct RouteInfo {
             Weight weight;
             std::vector<EdgeId> edges;
         };
 
-        std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+        virtual ~RouterBase() = default;
+
+        virtual std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const = 0;
+
+        // Routes from one vertex to every target, in the order of the targets.
+        // Engines able to answer all targets with one search override it.
+        virtual std::vector<std::optional<RouteInfo>> BuildRoutes(VertexId from, const std::vector<VertexId>& targets) const {
+            std::vector<std::optional<RouteInfo>> routes;
+            routes.reserve(targets.size());
+            for (const VertexId to : targets) {
+                routes.push_back(BuildRoute(from, to));
+            }
+            return routes;
+        }
+
+        // Called after weights of the graph's edges have changed, old_weights holds the edges with their previous weights.
+        // Returns true if the engine has brought its precomputed state up to date, false if it has to be built anew.
+        virtual bool UpdateEdgeWeights(const std::vector<std::pair<EdgeId, Weight>>& old_weights) {
+            return old_weights.empty();
+        }
+    };
+
+    namespace detail {
+
+        // Min-plus kernel of the all-pairs precompute, the hot loop of the whole computation:
+        // weights[j] = min(weights[j], through_weight + through_weights[j]) for j in [0, count),
+        // prev_edges[j] follows the weight and is taken from through_prev_edges[j] on improvement.
+        template <typename Weight, typename EdgeIndex>
+        void RelaxRowThroughVertex(Weight* weights, EdgeIndex* prev_edges, Weight through_weight,
+            const Weight* through_weights, const EdgeIndex* through_prev_edges, size_t count) {
+            for (size_t j = 0; j < count; ++j) {
+                const Weight candidate_weight = through_weight + through_weights[j];
+                const bool is_better = candidate_weight < weights[j];
+                weights[j] = is_better ? candidate_weight : weights[j];
+                prev_edges[j] = is_better ? through_prev_edges[j] : prev_edges[j];
+            }
+        }
+
+#if defined(__AVX2__)
+        inline void RelaxRowThroughVertex(double* weights, uint32_t* prev_edges, double through_weight,
+            const double* through_weights, const uint32_t* through_prev_edges, size_t count) {
+            const __m256d through = _mm256_set1_pd(through_weight);
+            // Picks the low halves of the four 64-bit comparison masks as a mask for four 32-bit edge ids
+            const __m256i mask_halves = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+            size_t j = 0;
+            for (; j + 4 <= count; j += 4) {
+                const __m256d candidate = _mm256_add_pd(through, _mm256_loadu_pd(through_weights + j));
+                const __m256d current = _mm256_loadu_pd(weights + j);
+                const __m256d is_better = _mm256_cmp_pd(candidate, current, _CMP_LT_OQ);
+                _mm256_storeu_pd(weights + j, _mm256_blendv_pd(current, candidate, is_better));
+                const __m128 edge_mask = _mm256_castps256_ps128(_mm256_permutevar8x32_ps(_mm256_castpd_ps(is_better), mask_halves));
+                const __m128 prev = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(prev_edges + j)));
+                const __m128 through_prev = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(through_prev_edges + j)));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(prev_edges + j), _mm_castps_si128(_mm_blendv_ps(prev, through_prev, edge_mask)));
+            }
+            RelaxRowThroughVertex<double, uint32_t>(weights + j, prev_edges + j, through_weight,
+                through_weights + j, through_prev_edges + j, count - j);
+        }
+
+        inline void RelaxRowThroughVertex(float* weights, uint32_t* prev_edges, float through_weight,
+            const float* through_weights, const uint32_t* through_prev_edges, size_t count) {
+            const __m256 through = _mm256_set1_ps(through_weight);
+            size_t j = 0;
+            for (; j + 8 <= count; j += 8) {
+                const __m256 candidate = _mm256_add_ps(through, _mm256_loadu_ps(through_weights + j));
+                const __m256 current = _mm256_loadu_ps(weights + j);
+                const __m256 is_better = _mm256_cmp_ps(candidate, current, _CMP_LT_OQ);
+                _mm256_storeu_ps(weights + j, _mm256_blendv_ps(current, candidate, is_better));
+                const __m256 prev = _mm256_castsi256_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(prev_edges + j)));
+                const __m256 through_prev = _mm256_castsi256_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(through_prev_edges + j)));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(prev_edges + j), _mm256_castps_si256(_mm256_blendv_ps(prev, through_prev, is_better)));
+            }
+            RelaxRowThroughVertex<float, uint32_t>(weights + j, prev_edges + j, through_weight,
+                through_weights + j, through_prev_edges + j, count - j);
+        }
+
+        // Fixed-point weights are below 2^31, so the signed comparison is exact
+        inline void RelaxRowThroughVertex(uint32_t* weights, uint32_t* prev_edges, uint32_t through_weight,
+            const uint32_t* through_weights, const uint32_t* through_prev_edges, size_t count) {
+            const __m256i through = _mm256_set1_epi32(static_cast<int>(through_weight));
+            size_t j = 0;
+            for (; j + 8 <= count; j += 8) {
+                const __m256i candidate = _mm256_add_epi32(through, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(through_weights + j)));
+                const __m256i current = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + j));
+                const __m256i is_better = _mm256_cmpgt_epi32(current, candidate);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(weights + j), _mm256_blendv_epi8(current, candidate, is_better));
+                const __m256i prev = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(prev_edges + j));
+                const __m256i through_prev = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(through_prev_edges + j));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(prev_edges + j), _mm256_blendv_epi8(prev, through_prev, is_better));
+            }
+            RelaxRowThroughVertex<uint32_t, uint32_t>(weights + j, prev_edges + j, through_weight,
+                through_weights + j, through_prev_edges + j, count - j);
+        }
+#elif defined(__SSE2__)
+        inline void RelaxRowThroughVertex(double* weights, uint32_t* prev_edges, double through_weight,
+            const double* through_weights, const uint32_t* through_prev_edges, size_t count) {
+            const __m128d through = _mm_set1_pd(through_weight);
+            size_t j = 0;
+            for (; j + 2 <= count; j += 2) {
+                const __m128d candidate = _mm_add_pd(through, _mm_loadu_pd(through_weights + j));
+                const __m128d current = _mm_loadu_pd(weights + j);
+                const __m128d is_better = _mm_cmplt_pd(candidate, current);
+                _mm_storeu_pd(weights + j, _mm_or_pd(_mm_and_pd(is_better, candidate), _mm_andnot_pd(is_better, current)));
+                // Low halves of the two 64-bit comparison masks form the mask for two 32-bit edge ids
+                const __m128i edge_mask = _mm_shuffle_epi32(_mm_castpd_si128(is_better), _MM_SHUFFLE(2, 0, 2, 0));
+                const __m128i prev = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(prev_edges + j));
+                const __m128i through_prev = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(through_prev_edges + j));
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(prev_edges + j),
+                    _mm_or_si128(_mm_and_si128(edge_mask, through_prev), _mm_andnot_si128(edge_mask, prev)));
+            }
+            RelaxRowThroughVertex<double, uint32_t>(weights + j, prev_edges + j, through_weight,
+                through_weights + j, through_prev_edges + j, count - j);
+        }
+
+        inline void RelaxRowThroughVertex(float* weights, uint32_t* prev_edges, float through_weight,
+            const float* through_weights, const uint32_t* through_prev_edges, size_t count) {
+            const __m128 through = _mm_set1_ps(through_weight);
+            size_t j = 0;
+            for (; j + 4 <= count; j += 4) {
+                const __m128 candidate = _mm_add_ps(through, _mm_loadu_ps(through_weights + j));
+                const __m128 current = _mm_loadu_ps(weights + j);
+                const __m128 is_better = _mm_cmplt_ps(candidate, current);
+                _mm_storeu_ps(weights + j, _mm_or_ps(_mm_and_ps(is_better, candidate), _mm_andnot_ps(is_better, current)));
+                const __m128i edge_mask = _mm_castps_si128(is_better);
+                const __m128i prev = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prev_edges + j));
+                const __m128i through_prev = _mm_loadu_si128(reinterpret_cast<const __m128i*>(through_prev_edges + j));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(prev_edges + j),
+                    _mm_or_si128(_mm_and_si128(edge_mask, through_prev), _mm_andnot_si128(edge_mask, prev)));
+            }
+            RelaxRowThroughVertex<float, uint32_t>(weights + j, prev_edges + j, through_weight,
+                through_weights + j, through_prev_edges + j, count - j);
+        }
+
+        // Fixed-point weights are below 2^31, so the signed comparison is exact
+        inline void RelaxRowThroughVertex(uint32_t* weights, uint32_t* prev_edges, uint32_t through_weight,
+            const uint32_t* through_weights, const uint32_t* through_prev_edges, size_t count) {
+            const __m128i through = _mm_set1_epi32(static_cast<int>(through_weight));
+            size_t j = 0;
+            for (; j + 4 <= count; j += 4) {
+                const __m128i candidate = _mm_add_epi32(through, _mm_loadu_si128(reinterpret_cast<const __m128i*>(through_weights + j)));
+                const __m128i current = _mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + j));
+                const __m128i is_better = _mm_cmpgt_epi32(current, candidate);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(weights + j),
+                    _mm_or_si128(_mm_and_si128(is_better, candidate), _mm_andnot_si128(is_better, current)));
+                const __m128i prev = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prev_edges + j));
+                const __m128i through_prev = _mm_loadu_si128(reinterpret_cast<const __m128i*>(through_prev_edges + j));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(prev_edges + j),
+                    _mm_or_si128(_mm_and_si128(is_better, through_prev), _mm_andnot_si128(is_better, prev)));
+            }
+            RelaxRowThroughVertex<uint32_t, uint32_t>(weights + j, prev_edges + j, through_weight,
+                through_weights + j, through_prev_edges + j, count - j);
+        }
+#endif
+
+        // Priority queue of a Dijkstra search, a binary heap
+        template <typename Weight>
+        class BinaryHeap {
+        public:
+            bool IsEmpty() const {
+                return entries_.empty();
+            }
+
+            void Push(Weight weight, VertexId vertex) {
+                entries_.push_back({ weight, vertex });
+                std::push_heap(entries_.begin(), entries_.end(), std::greater<Entry>{});
+            }
+
+            std::pair<Weight, VertexId> Pop() {
+                std::pop_heap(entries_.begin(), entries_.end(), std::greater<Entry>{});
+                const Entry entry = entries_.back();
+                entries_.pop_back();
+                return entry;
+            }
+
+        private:
+            using Entry = std::pair<Weight, VertexId>;
+            std::vector<Entry> entries_;
+        };
+
+        // Monotone priority queue of a Dijkstra search over unsigned integer weights.
+        // Bucket i holds the entries whose weight first differs from the last popped one in bit i - 1;
+        // an entry moves only to lower buckets, so a push and a pop cost O(bits) amortized.
+        template <typename Weight>
+        class RadixHeap {
+        public:
+            bool IsEmpty() const {
+                return size_ == 0;
+            }
+
+            void Push(Weight weight, VertexId vertex) {
+                buckets_[GetBucket(weight)].push_back({ weight, vertex });
+                ++size_;
+            }
+
+            std::pair<Weight, VertexId> Pop() {
+                if (buckets_[0].empty()) {
+                    size_t bucket = 1;
+                    while (buckets_[bucket].empty()) {
+                        ++bucket;
+                    }
+                    last_weight_ = std::min_element(buckets_[bucket].begin(), buckets_[bucket].end())->first;
+                    for (const Entry& entry : buckets_[bucket]) {
+                        buckets_[GetBucket(entry.first)].push_back(entry);
+                    }
+                    buckets_[bucket].clear();
+                }
+                const Entry entry = buckets_[0].back();
+                buckets_[0].pop_back();
+                --size_;
+                return entry;
+            }
+
+        private:
+            using Entry = std::pair<Weight, VertexId>;
+            static constexpr size_t BIT_COUNT = std::numeric_limits<Weight>::digits;
+
+            size_t GetBucket(Weight weight) const {
+                size_t bucket = 0;
+                for (Weight diff = weight ^ last_weight_; diff != 0; diff >>= 1) {
+                    ++bucket;
+                }
+                return bucket;
+            }
+
+            std::array<std::vector<Entry>, BIT_COUNT + 1> buckets_;
+            Weight last_weight_{};
+            size_t size_ = 0;
+        };
+
+    } // namespace detail
 
+    // All-pairs engine: precomputes every route in the constructor, answers queries by table lookup.
+    //
+    // The precompute is Floyd-Warshall over contiguous V x V weight and predecessor tables with an infinite
+    // weight for unreachable pairs. Steps are processed in blocks of BLOCK_SIZE intermediate vertices:
+    // the rows of the block's vertices are relaxed first and saved as a panel, then all other rows are
+    // relaxed through the panel in tiles of rows and columns, in parallel. Each row still goes through the
+    // intermediate vertices in the same order and with the same operands as the textbook loop,
+    // so the tables are identical to the sequential computation.
+    //
+    // TableWeight is the weight type of the tables. Router<double, float> halves the table memory
+    // at the cost of float precision in the comparison of routes. Router<double, uint32_t> takes the same memory
+    // with fixed-point weights (see WeightTraits): the sums are exact, so the tables do not depend on the order
+    // of the additions. Predecessor edges are stored as 32-bit ids, a table cell takes 12 bytes with double weights
+    // and 8 bytes with float or integer ones.
+    template <typename Weight, typename TableWeight = Weight>
+    class Router : public RouterBase<Weight> {
     private:
-        struct RouteInternalData {
-            Weight weight;
-            std::optional<EdgeId> prev_edge;
+        using Graph = DirectedWeightedGraph<Weight>;
+
+    public:
+        using RouteInfo = typename RouterBase<Weight>::RouteInfo;
+
+        // Predecessor edge of the route, the last edge on the way from the row vertex to the column vertex
+        using EdgeIndex = uint32_t;
+
+        // Tables computed earlier and kept in external memory, e.g. a mapped file.
+        // Both arrays hold vertex_count * vertex_count cells in row-major order, holder keeps the memory alive.
+        struct TableView {
+            const TableWeight* weights = nullptr;
+            const EdgeIndex* prev_edges = nullptr;
+            std::shared_ptr<const void> holder;
         };
-        using RoutesInternalData = std::vector<std::vector<std::optional<RouteInternalData>>>;
+
+        // The tables are computed and repaired on the pool, which has to outlive the router.
+        // Throws std::overflow_error if a route is too long for the integer table weights
+        Router(const Graph& graph, thread_pool::ThreadPool& pool);
+        Router(const Graph& graph, TableView table, thread_pool::ThreadPool& pool);
+
+        std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+
+        // Increased weights: only the rows whose shortest path tree contains the edge are recomputed by Dijkstra.
+        // Decreased weights: every row is relaxed through the edge, O(V^2) per edge.
+        // Returns false if a route became too long for the integer table weights.
+        bool UpdateEdgeWeights(const std::vector<std::pair<EdgeId, Weight>>& old_weights) override;
+
+        TableView GetTable() const;
+
+    private:
+        static constexpr size_t BLOCK_SIZE = 32;
+        static constexpr size_t ROW_TILE_SIZE = 16;
+        static constexpr size_t COLUMN_TILE_SIZE = 512;
+        static constexpr size_t REPAIR_COST_FACTOR = 64;
 
         void InitializeRoutesInternalData(const Graph& graph) {
             const size_t vertex_count = graph.GetVertexCount();
             for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
-                routes_internal_data_[vertex][vertex] = RouteInternalData{ ZERO_WEIGHT, std::nullopt };
+                weights_[vertex * vertex_count + vertex] = ZERO_WEIGHT;
                 for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
                     const auto& edge = graph.GetEdge(edge_id);
                     if (edge.weight < ZERO_WEIGHT) {
                         throw std::domain_error("Edges' weights should be non-negative");
                     }
-                    auto& route_internal_data = routes_internal_data_[vertex][edge.to];
-                    if (!route_internal_data || route_internal_data->weight > edge.weight) {
-                        route_internal_data = RouteInternalData{ edge.weight, edge_id };
+                    const size_t index = vertex * vertex_count + edge.to;
+                    const TableWeight edge_weight = WeightTraits<TableWeight>::FromReal(edge.weight);
+                    if (weights_[index] > edge_weight) {
+                        weights_[index] = edge_weight;
+                        prev_edges_[index] = static_cast<EdgeIndex>(edge_id);
                     }
                 }
             }
         }
 
-        void RelaxRoute(VertexId vertex_from, VertexId vertex_to, const RouteInternalData& route_from,
-            const RouteInternalData& route_to) {
-            auto& route_relaxing = routes_internal_data_[vertex_from][vertex_to];
-            const Weight candidate_weight = route_from.weight + route_to.weight;
-            if (!route_relaxing || candidate_weight < route_relaxing->weight) {
-                route_relaxing = { candidate_weight,
-                                  route_to.prev_edge ? route_to.prev_edge : route_from.prev_edge };
+        TableWeight* GetWeights(VertexId vertex_from) {
+            return weights_.data() + vertex_from * vertex_count_;
+        }
+
+        EdgeIndex* GetPrevEdges(VertexId vertex_from) {
+            return prev_edges_.data() + vertex_from * vertex_count_;
+        }
+
+        void RelaxBlock(VertexId block_begin, VertexId block_end);
+
+        // The whole precompute over the current graph
+        void ComputeTables();
+
+        // Tables in external memory are read-only, updates work on an owned copy
+        void MakeTableOwned();
+
+        // Integer tables lose the routes of INFINITE_WEIGHT and longer, as if they did not exist: then some edge
+        // leads from a vertex of a row to a vertex missing in the row. Always true for floating point tables.
+        bool IsTableInRange() const;
+
+        // Dijkstra from the vertex over the current graph
+        void RecomputeRow(VertexId vertex_from);
+
+        // Routes which enter the edge's end through the edge
+        void RelaxThroughEdge(EdgeId edge_id);
+
+        static constexpr TableWeight ZERO_WEIGHT{};
+        static constexpr TableWeight INFINITE_WEIGHT = WeightTraits<TableWeight>::INFINITE_WEIGHT;
+        static constexpr EdgeIndex NO_EDGE = std::numeric_limits<EdgeIndex>::max();
+        const Graph& graph_;
+        thread_pool::ThreadPool& pool_;
+        const size_t vertex_count_;
+        std::vector<TableWeight> weights_;
+        std::vector<EdgeIndex> prev_edges_;
+        TableView table_;
+    };
+
+    template <typename Weight, typename TableWeight>
+    Router<Weight, TableWeight>::Router(const Graph& graph, thread_pool::ThreadPool& pool)
+        : graph_(graph)
+        , pool_(pool)
+        , vertex_count_(graph.GetVertexCount())
+        , weights_(vertex_count_ * vertex_count_, INFINITE_WEIGHT)
+        , prev_edges_(vertex_count_ * vertex_count_, NO_EDGE)
+    {
+        if (graph.GetEdgeCount() >= NO_EDGE) {
+            throw std::length_error("Too many edges for 32-bit edge ids of the routes table");
+        }
+        ComputeTables();
+        if (!IsTableInRange()) {
+            throw std::overflow_error("Routes too long for the weights of the routes table");
+        }
+    }
+
+    template <typename Weight, typename TableWeight>
+    void Router<Weight, TableWeight>::ComputeTables() {
+        std::fill(weights_.begin(), weights_.end(), INFINITE_WEIGHT);
+        std::fill(prev_edges_.begin(), prev_edges_.end(), NO_EDGE);
+        InitializeRoutesInternalData(graph_);
+
+        for (VertexId block_begin = 0; block_begin < vertex_count_; block_begin += BLOCK_SIZE) {
+            RelaxBlock(block_begin, std::min(block_begin + BLOCK_SIZE, vertex_count_));
+        }
+        table_ = TableView{ weights_.data(), prev_edges_.data(), nullptr };
+    }
+
+    template <typename Weight, typename TableWeight>
+    Router<Weight, TableWeight>::Router(const Graph& graph, TableView table, thread_pool::ThreadPool& pool)
+        : graph_(graph)
+        , pool_(pool)
+        , vertex_count_(graph.GetVertexCount())
+        , table_(std::move(table))
+    {
+    }
+
+    template <typename Weight, typename TableWeight>
+    typename Router<Weight, TableWeight>::TableView Router<Weight, TableWeight>::GetTable() const {
+        return table_;
+    }
+
+    template <typename Weight, typename TableWeight>
+    void Router<Weight, TableWeight>::RelaxBlock(VertexId block_begin, VertexId block_end) {
+        const size_t block_size = block_end - block_begin;
+
+        // Rows of the block's vertices, each saved at the moment it is used as the intermediate vertex.
+        // A row is not changed by the step through its own vertex, so the saved row is exactly
+        // what the sequential loop reads during that step.
+        std::vector<TableWeight> panel_weights(block_size * vertex_count_);
+        std::vector<EdgeIndex> panel_prev_edges(block_size * vertex_count_);
+        for (VertexId vertex_through = block_begin; vertex_through < block_end; ++vertex_through) {
+            const size_t panel_offset = (vertex_through - block_begin) * vertex_count_;
+            std::copy_n(GetWeights(vertex_through), vertex_count_, panel_weights.begin() + panel_offset);
+            std::copy_n(GetPrevEdges(vertex_through), vertex_count_, panel_prev_edges.begin() + panel_offset);
+            for (VertexId vertex_from = block_begin; vertex_from < block_end; ++vertex_from) {
+                const TableWeight through_weight = GetWeights(vertex_from)[vertex_through];
+                if (through_weight < INFINITE_WEIGHT) {
+                    detail::RelaxRowThroughVertex(GetWeights(vertex_from), GetPrevEdges(vertex_from), through_weight,
+                        panel_weights.data() + panel_offset, panel_prev_edges.data() + panel_offset, vertex_count_);
+                }
             }
         }
 
-        void RelaxRoutesInternalDataThroughVertex(size_t vertex_count, VertexId vertex_through) {
-            for (VertexId vertex_from = 0; vertex_from < vertex_count; ++vertex_from) {
-                if (const auto& route_from = routes_internal_data_[vertex_from][vertex_through]) {
-                    for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to) {
-                        if (const auto& route_to = routes_internal_data_[vertex_through][vertex_to]) {
-                            RelaxRoute(vertex_from, vertex_to, *route_from, *route_to);
+        // All other rows, in tiles of ROW_TILE_SIZE rows which are processed in parallel
+        const size_t row_tile_count = (vertex_count_ + ROW_TILE_SIZE - 1) / ROW_TILE_SIZE;
+        pool_.ParallelFor(row_tile_count, [&](size_t row_tile) {
+            const VertexId row_begin = row_tile * ROW_TILE_SIZE;
+            const VertexId row_end = std::min(row_begin + ROW_TILE_SIZE, vertex_count_);
+
+            // The block's columns go first: they hold the row's weights to the intermediate vertices
+            // at the moment of each step, the rest of the row only reads them
+            std::vector<TableWeight> through_weights((row_end - row_begin) * block_size);
+            for (VertexId vertex_from = row_begin; vertex_from < row_end; ++vertex_from) {
+                if (vertex_from >= block_begin && vertex_from < block_end) {
+                    continue;
+                }
+                TableWeight* row_weights = GetWeights(vertex_from);
+                EdgeIndex* row_prev_edges = GetPrevEdges(vertex_from);
+                TableWeight* row_through_weights = through_weights.data() + (vertex_from - row_begin) * block_size;
+                for (size_t step = 0; step < block_size; ++step) {
+                    const TableWeight through_weight = row_weights[block_begin + step];
+                    row_through_weights[step] = through_weight;
+                    if (through_weight < INFINITE_WEIGHT) {
+                        const size_t panel_offset = step * vertex_count_ + block_begin;
+                        detail::RelaxRowThroughVertex(row_weights + block_begin, row_prev_edges + block_begin, through_weight,
+                            panel_weights.data() + panel_offset, panel_prev_edges.data() + panel_offset, block_size);
+                    }
+                }
+            }
+
+            auto relax_columns = [&](VertexId column_begin, VertexId column_end) {
+                for (VertexId tile_begin = column_begin; tile_begin < column_end; tile_begin += COLUMN_TILE_SIZE) {
+                    const size_t tile_size = std::min(COLUMN_TILE_SIZE, column_end - tile_begin);
+                    for (VertexId vertex_from = row_begin; vertex_from < row_end; ++vertex_from) {
+                        if (vertex_from >= block_begin && vertex_from < block_end) {
+                            continue;
                         }
+                        TableWeight* row_weights = GetWeights(vertex_from) + tile_begin;
+                        EdgeIndex* row_prev_edges = GetPrevEdges(vertex_from) + tile_begin;
+                        const TableWeight* row_through_weights = through_weights.data() + (vertex_from - row_begin) * block_size;
+                        for (size_t step = 0; step < block_size; ++step) {
+                            if (row_through_weights[step] < INFINITE_WEIGHT) {
+                                const size_t panel_offset = step * vertex_count_ + tile_begin;
+                                detail::RelaxRowThroughVertex(row_weights, row_prev_edges, row_through_weights[step],
+                                    panel_weights.data() + panel_offset, panel_prev_edges.data() + panel_offset, tile_size);
+                            }
+                        }
+                    }
+                }
+            };
+            relax_columns(0, block_begin);
+            relax_columns(block_end, vertex_count_);
+        });
+    }
+
+    template <typename Weight, typename TableWeight>
+    bool Router<Weight, TableWeight>::UpdateEdgeWeights(const std::vector<std::pair<EdgeId, Weight>>& old_weights) {
+        if (old_weights.empty()) {
+            return true;
+        }
+        MakeTableOwned();
+
+        // The table is exact for the old weights. Increases are handled first: the recomputed rows are exact
+        // for the new graph, the others for the graph with only the increases. The decreases then are applied
+        // one by one, each keeping the table exact for the graph with the edges decreased so far.
+        std::vector<char> is_row_affected(vertex_count_, 0);
+        std::vector<EdgeId> decreased_edges;
+        for (const auto& [edge_id, old_weight] : old_weights) {
+            const auto& edge = graph_.GetEdge(edge_id);
+            if (edge.weight < Weight{}) {
+                throw std::domain_error("Edges' weights should be non-negative");
+            }
+            if (edge.weight < old_weight) {
+                decreased_edges.push_back(edge_id);
+            }
+            else if (old_weight < edge.weight) {
+                for (VertexId vertex_from = 0; vertex_from < vertex_count_; ++vertex_from) {
+                    if (GetPrevEdges(vertex_from)[edge.to] == edge_id) {
+                        is_row_affected[vertex_from] = 1;
                     }
                 }
             }
         }
 
-        static constexpr Weight ZERO_WEIGHT{};
-        const Graph& graph_;
-        RoutesInternalData routes_internal_data_;
-    };
+        // A Dijkstra row costs about E log V, the blocked precompute V^3 with a much smaller constant
+        const size_t affected_row_count = std::count(is_row_affected.begin(), is_row_affected.end(), 1);
+        if (affected_row_count * graph_.GetEdgeCount() * REPAIR_COST_FACTOR > vertex_count_ * vertex_count_ * vertex_count_) {
+            ComputeTables();
+            return IsTableInRange();
+        }
+        pool_.ParallelFor(vertex_count_, [&](size_t vertex_from) {
+            if (is_row_affected[vertex_from]) {
+                RecomputeRow(vertex_from);
+            }
+        });
+        for (const EdgeId edge_id : decreased_edges) {
+            RelaxThroughEdge(edge_id);
+        }
+        return IsTableInRange();
+    }
 
-    template <typename Weight>
-    Router<Weight>::Router(const Graph& graph)
-        : graph_(graph)
-        , routes_internal_data_(graph.GetVertexCount(),
-            std::vector<std::optional<RouteInternalData>>(graph.GetVertexCount()))
-    {
-        InitializeRoutesInternalData(graph);
+    template <typename Weight, typename TableWeight>
+    void Router<Weight, TableWeight>::MakeTableOwned() {
+        if (!table_.holder) {
+            return;
+        }
+        const size_t cell_count = vertex_count_ * vertex_count_;
+        weights_.assign(table_.weights, table_.weights + cell_count);
+        prev_edges_.assign(table_.prev_edges, table_.prev_edges + cell_count);
+        table_ = TableView{ weights_.data(), prev_edges_.data(), nullptr };
+    }
+
+    template <typename Weight, typename TableWeight>
+    bool Router<Weight, TableWeight>::IsTableInRange() const {
+        if constexpr (std::is_integral_v<TableWeight>) {
+            std::vector<std::pair<VertexId, VertexId>> open_edges;
+            TableWeight max_edge_weight = ZERO_WEIGHT;
+            for (EdgeId edge_id = 0; edge_id < graph_.GetEdgeCount(); ++edge_id) {
+                const auto& edge = graph_.GetEdge(edge_id);
+                if constexpr (std::numeric_limits<Weight>::has_infinity) {
+                    // Closed edges are not a part of any route
+                    if (edge.weight == std::numeric_limits<Weight>::infinity()) {
+                        continue;
+                    }
+                }
+                const TableWeight edge_weight = WeightTraits<TableWeight>::FromReal(edge.weight);
+                if (!(edge_weight < INFINITE_WEIGHT)) {
+                    return false;
+                }
+                max_edge_weight = std::max(max_edge_weight, edge_weight);
+                open_edges.emplace_back(edge.from, edge.to);
+            }
+
+            // Usually no route comes close to the limit, then no edge can extend a route of the table beyond it
+            const TableWeight* weights = table_.weights;
+            TableWeight max_weight = ZERO_WEIGHT;
+            for (size_t index = 0; index < vertex_count_ * vertex_count_; ++index) {
+                max_weight = weights[index] < INFINITE_WEIGHT ? std::max(max_weight, weights[index]) : max_weight;
+            }
+            if (max_weight + max_edge_weight < INFINITE_WEIGHT) {
+                return true;
+            }
 
-        const size_t vertex_count = graph.GetVertexCount();
-        for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
-            RelaxRoutesInternalDataThroughVertex(vertex_count, vertex_through);
+            for (VertexId vertex_from = 0; vertex_from < vertex_count_; ++vertex_from) {
+                const TableWeight* row_weights = weights + vertex_from * vertex_count_;
+                for (const auto& [edge_from, edge_to] : open_edges) {
+                    if (row_weights[edge_from] < INFINITE_WEIGHT && !(row_weights[edge_to] < INFINITE_WEIGHT)) {
+                        return false;
+                    }
+                }
+            }
         }
+        return true;
     }
 
-    template <typename Weight>
-    std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(VertexId from,
+    template <typename Weight, typename TableWeight>
+    void Router<Weight, TableWeight>::RecomputeRow(VertexId vertex_from) {
+        // The row is summed up in the table's arithmetic, as the precompute does
+        using Queue = std::conditional_t<std::is_integral_v<TableWeight>, detail::RadixHeap<TableWeight>,
+            detail::BinaryHeap<TableWeight>>;
+        TableWeight* distances = GetWeights(vertex_from);
+        EdgeIndex* prev_edges = GetPrevEdges(vertex_from);
+        std::fill(distances, distances + vertex_count_, INFINITE_WEIGHT);
+        std::fill(prev_edges, prev_edges + vertex_count_, NO_EDGE);
+        Queue queue;
+        distances[vertex_from] = ZERO_WEIGHT;
+        queue.Push(ZERO_WEIGHT, vertex_from);
+        while (!queue.IsEmpty()) {
+            const auto [weight, vertex] = queue.Pop();
+            if (weight > distances[vertex]) {
+                continue;
+            }
+            for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+                const auto& edge = graph_.GetEdge(edge_id);
+                const TableWeight edge_weight = WeightTraits<TableWeight>::FromReal(edge.weight);
+                if (!(edge_weight < INFINITE_WEIGHT)) {
+                    continue;
+                }
+                const TableWeight new_weight = weight + edge_weight;
+                if (new_weight < distances[edge.to]) {
+                    distances[edge.to] = new_weight;
+                    prev_edges[edge.to] = static_cast<EdgeIndex>(edge_id);
+                    queue.Push(new_weight, edge.to);
+                }
+            }
+        }
+    }
+
+    template <typename Weight, typename TableWeight>
+    void Router<Weight, TableWeight>::RelaxThroughEdge(EdgeId edge_id) {
+        const auto& edge = graph_.GetEdge(edge_id);
+        const TableWeight edge_weight = WeightTraits<TableWeight>::FromReal(edge.weight);
+        if (!(edge_weight < INFINITE_WEIGHT)) {
+            return;
+        }
+        // Routes from the edge's end, extended at the front by the edge itself
+        std::vector<TableWeight> through_weights(GetWeights(edge.to), GetWeights(edge.to) + vertex_count_);
+        std::vector<EdgeIndex> through_prev_edges(GetPrevEdges(edge.to), GetPrevEdges(edge.to) + vertex_count_);
+        through_prev_edges[edge.to] = static_cast<EdgeIndex>(edge_id);
+
+        const size_t row_tile_count = (vertex_count_ + ROW_TILE_SIZE - 1) / ROW_TILE_SIZE;
+        pool_.ParallelFor(row_tile_count, [&](size_t row_tile) {
+            const VertexId row_end = std::min((row_tile + 1) * ROW_TILE_SIZE, vertex_count_);
+            for (VertexId vertex_from = row_tile * ROW_TILE_SIZE; vertex_from < row_end; ++vertex_from) {
+                // Every route through the edge passes its end, so the row gains nothing unless the end itself gets closer
+                const TableWeight weight_to_edge = GetWeights(vertex_from)[edge.from];
+                if (weight_to_edge < INFINITE_WEIGHT && weight_to_edge + edge_weight < GetWeights(vertex_from)[edge.to]) {
+                    detail::RelaxRowThroughVertex(GetWeights(vertex_from), GetPrevEdges(vertex_from), weight_to_edge + edge_weight,
+                        through_weights.data(), through_prev_edges.data(), vertex_count_);
+                }
+            }
+        });
+    }
+
+    template <typename Weight, typename TableWeight>
+    std::optional<typename Router<Weight, TableWeight>::RouteInfo> Router<Weight, TableWeight>::BuildRoute(VertexId from,
         VertexId to) const {
-        const auto& route_internal_data = routes_internal_data_.at(from).at(to);
-        if (!route_internal_data) {
+        if (from >= vertex_count_ || to >= vertex_count_) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+        const TableWeight* route_weights = table_.weights + from * vertex_count_;
+        const EdgeIndex* route_prev_edges = table_.prev_edges + from * vertex_count_;
+        if (!(route_weights[to] < INFINITE_WEIGHT)) {
             return std::nullopt;
         }
-        const Weight weight = route_internal_data->weight;
+        Weight weight = static_cast<Weight>(route_weights[to]);
         std::vector<EdgeId> edges;
-        for (std::optional<EdgeId> edge_id = route_internal_data->prev_edge;
-            edge_id;
-            edge_id = routes_internal_data_[from][graph_.GetEdge(*edge_id).from]->prev_edge)
+        for (EdgeIndex edge_id = route_prev_edges[to];
+            edge_id != NO_EDGE;
+            edge_id = route_prev_edges[graph_.GetEdge(edge_id).from])
         {
-            edges.push_back(*edge_id);
+            edges.push_back(edge_id);
         }
         std::reverse(edges.begin(), edges.end());
 
+        if constexpr (!std::is_same_v<Weight, TableWeight>) {
+            // The table weight is rounded, the route weight is summed up in the graph's precision
+            weight = Weight{};
+            for (const EdgeId edge_id : edges) {
+                weight += graph_.GetEdge(edge_id).weight;
+            }
+        }
+
         return RouteInfo{ weight, std::move(edges) };
     }
 
@@ -0,0 +1,223 @@
+#include "routing_cache.h"
+
+#include <cstdio>
+#include <fstream>
+
+#ifdef _WIN32
+#include <io.h>
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace routing_cache {
+
+    namespace {
+
+        const char FILE_MAGIC[8] = { 'T', 'C', 'R', 'O', 'U', 'T', 'E', 'S' };
+        const uint32_t BYTE_ORDER_MARK = 0x01020304;
+        const uint64_t SECTION_ALIGNMENT = 64;
+
+        struct FileHeader {
+            char magic[8];
+            uint32_t version;
+            uint32_t byte_order_mark;
+            uint64_t key;
+            uint64_t vertex_count;
+            uint64_t edge_count;
+            uint64_t table_weight_size;
+            uint64_t edges_offset;
+            uint64_t weights_offset;
+            uint64_t prev_edges_offset;
+            uint64_t file_size;
+        };
+
+        struct FileEdge {
+            uint64_t from;
+            uint64_t to;
+            double weight;
+        };
+
+        uint64_t AlignOffset(uint64_t offset) {
+            return (offset + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+        }
+
+        FileHeader MakeHeader(uint64_t key, const graph::DirectedWeightedGraph<double>& graph, size_t table_weight_size) {
+            FileHeader header{};
+            std::memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+            header.version = FILE_VERSION;
+            header.byte_order_mark = BYTE_ORDER_MARK;
+            header.key = key;
+            header.vertex_count = graph.GetVertexCount();
+            header.edge_count = graph.GetEdgeCount();
+            header.table_weight_size = table_weight_size;
+
+            const uint64_t cell_count = header.vertex_count * header.vertex_count;
+            header.edges_offset = AlignOffset(sizeof(FileHeader));
+            header.weights_offset = AlignOffset(header.edges_offset + header.edge_count * sizeof(FileEdge));
+            header.prev_edges_offset = AlignOffset(header.weights_offset + cell_count * table_weight_size);
+            header.file_size = header.prev_edges_offset + cell_count * sizeof(uint32_t);
+            return header;
+        }
+
+        FileEdge MakeFileEdge(const graph::Edge<double>& edge) {
+            return FileEdge{ edge.from, edge.to, edge.weight };
+        }
+
+        // Creates an empty file of a unique name next to path, so that concurrent writers of the same cache
+        // do not share it and the rename stays within one file system. Returns an empty string on failure.
+        std::string CreateTempFile(const std::string& path) {
+            std::string temp_path = path + ".XXXXXX";
+#ifdef _WIN32
+            if (_mktemp_s(temp_path.data(), temp_path.size() + 1) != 0) {
+                return {};
+            }
+            std::ofstream output(temp_path, std::ios::binary | std::ios::trunc);
+            return output ? temp_path : std::string();
+#else
+            const int fd = mkstemp(temp_path.data());
+            if (fd == -1) {
+                return {};
+            }
+            // mkstemp creates the file readable by the owner only, the cache is as readable as an ordinary file
+            fchmod(fd, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+            close(fd);
+            return temp_path;
+#endif
+        }
+
+    } // namespace
+
+    void Hasher::Add(const void* data, size_t size) {
+        const auto* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            hash_ ^= bytes[i];
+            hash_ *= 1099511628211ull;
+        }
+    }
+
+    void Hasher::Add(std::string_view str) {
+        Add(str.size());
+        Add(str.data(), str.size());
+    }
+
+    uint64_t Hasher::GetHash() const {
+        return hash_;
+    }
+
+    std::shared_ptr<const MappedFile> MappedFile::Open(const std::string& path) {
+        std::shared_ptr<MappedFile> mapped_file(new MappedFile());
+#ifdef _WIN32
+        std::ifstream input(path, std::ios::binary);
+        if (!input) {
+            return nullptr;
+        }
+        mapped_file->buffer_.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+        mapped_file->data_ = mapped_file->buffer_.data();
+        mapped_file->size_ = mapped_file->buffer_.size();
+#else
+        const int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return nullptr;
+        }
+        struct stat file_stat {};
+        if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0) {
+            close(fd);
+            return nullptr;
+        }
+        void* data = mmap(nullptr, static_cast<size_t>(file_stat.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (data == MAP_FAILED) {
+            return nullptr;
+        }
+        mapped_file->data_ = static_cast<const char*>(data);
+        mapped_file->size_ = static_cast<size_t>(file_stat.st_size);
+#endif
+        return mapped_file;
+    }
+
+    MappedFile::~MappedFile() {
+#ifndef _WIN32
+        if (data_ != nullptr) {
+            munmap(const_cast<char*>(data_), size_);
+        }
+#endif
+    }
+
+    const char* MappedFile::GetData() const {
+        return data_;
+    }
+
+    size_t MappedFile::GetSize() const {
+        return size_;
+    }
+
+    bool SaveTable(const std::string& path, uint64_t key, const graph::DirectedWeightedGraph<double>& graph,
+        size_t table_weight_size, TableData table) {
+        const FileHeader header = MakeHeader(key, graph, table_weight_size);
+        const uint64_t cell_count = header.vertex_count * header.vertex_count;
+        const std::string temp_path = CreateTempFile(path);
+        if (temp_path.empty()) {
+            return false;
+        }
+        {
+            std::ofstream output(temp_path, std::ios::binary | std::ios::trunc);
+            auto pad_to = [&output](uint64_t offset) {
+                static const char zeros[SECTION_ALIGNMENT] = {};
+                output.write(zeros, offset - static_cast<uint64_t>(output.tellp()));
+            };
+
+            output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            pad_to(header.edges_offset);
+            for (graph::EdgeId edge_id = 0; edge_id < header.edge_count; ++edge_id) {
+                const FileEdge file_edge = MakeFileEdge(graph.GetEdge(edge_id));
+                output.write(reinterpret_cast<const char*>(&file_edge), sizeof(file_edge));
+            }
+            pad_to(header.weights_offset);
+            output.write(static_cast<const char*>(table.weights), cell_count * table_weight_size);
+            pad_to(header.prev_edges_offset);
+            output.write(reinterpret_cast<const char*>(table.prev_edges), cell_count * sizeof(uint32_t));
+            output.close();
+            if (!output) {
+                std::remove(temp_path.c_str());
+                return false;
+            }
+        }
+        if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+            std::remove(temp_path.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    std::optional<TableData> LoadTable(const std::string& path, uint64_t key, const graph::DirectedWeightedGraph<double>& graph,
+        size_t table_weight_size, std::shared_ptr<const MappedFile>& mapped_file) {
+        mapped_file = MappedFile::Open(path);
+        if (!mapped_file || mapped_file->GetSize() < sizeof(FileHeader)) {
+            return std::nullopt;
+        }
+
+        FileHeader header;
+        std::memcpy(&header, mapped_file->GetData(), sizeof(header));
+        const FileHeader expected_header = MakeHeader(key, graph, table_weight_size);
+        if (std::memcmp(&header, &expected_header, sizeof(header)) != 0 || mapped_file->GetSize() != header.file_size) {
+            return std::nullopt;
+        }
+
+        // The tables are valid only for the very same graph
+        const char* file_edges = mapped_file->GetData() + header.edges_offset;
+        for (graph::EdgeId edge_id = 0; edge_id < header.edge_count; ++edge_id) {
+            const FileEdge expected_edge = MakeFileEdge(graph.GetEdge(edge_id));
+            if (std::memcmp(file_edges + edge_id * sizeof(FileEdge), &expected_edge, sizeof(FileEdge)) != 0) {
+                return std::nullopt;
+            }
+        }
+
+        return TableData{ mapped_file->GetData() + header.weights_offset,
+            reinterpret_cast<const uint32_t*>(mapped_file->GetData() + header.prev_edges_offset) };
+    }
+
+} // namespace routing_cache
\ No newline at end of file
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// Binary file with the graph edges and the all-pairs routing tables of graph::Router.
+// Tables are stored in the in-memory layout and aligned, so a loaded file is mapped and used as is.
+namespace routing_cache {
+
+    inline const uint32_t FILE_VERSION = 1;
+
+    // 64-bit FNV-1a hash of a byte sequence, used as the key of the cached tables
+    class Hasher {
+    public:
+        void Add(const void* data, size_t size);
+        void Add(std::string_view str);
+
+        template <typename Number, std::enable_if_t<std::is_arithmetic_v<Number>, bool> = true>
+        void Add(Number number) {
+            Add(&number, sizeof(number));
+        }
+
+        uint64_t GetHash() const;
+
+    private:
+        uint64_t hash_ = 14695981039346656037ull;
+    };
+
+    // Read-only mapping of a whole file into memory
+    class MappedFile {
+    public:
+        // Returns nullptr if the file can not be opened or mapped
+        static std::shared_ptr<const MappedFile> Open(const std::string& path);
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        ~MappedFile();
+
+        const char* GetData() const;
+        size_t GetSize() const;
+
+    private:
+        MappedFile() = default;
+
+        const char* data_ = nullptr;
+        size_t size_ = 0;
+#ifdef _WIN32
+        std::vector<char> buffer_;
+#endif
+    };
+
+    struct TableData {
+        const void* weights = nullptr;
+        const uint32_t* prev_edges = nullptr;
+    };
+
+    // Writes the file atomically: to a temporary file which then replaces the old one.
+    // Returns false if the file could not be written.
+    bool SaveTable(const std::string& path, uint64_t key, const graph::DirectedWeightedGraph<double>& graph,
+        size_t table_weight_size, TableData table);
+
+    // Maps the file and checks it against the key, the version and the graph.
+    // Returns the table pointers into the mapping, or nothing if the file is missing or stale.
+    std::optional<TableData> LoadTable(const std::string& path, uint64_t key, const graph::DirectedWeightedGraph<double>& graph,
+        size_t table_weight_size, std::shared_ptr<const MappedFile>& mapped_file);
+
+    template <typename TableWeight>
+    bool SaveRouterTable(const std::string& path, uint64_t key, const graph::DirectedWeightedGraph<double>& graph,
+        const graph::Router<double, TableWeight>& router) {
+        const auto table = router.GetTable();
+        return SaveTable(path, key, graph, sizeof(TableWeight), TableData{ table.weights, table.prev_edges });
+    }
+
+    template <typename TableWeight>
+    std::optional<typename graph::Router<double, TableWeight>::TableView> LoadRouterTable(const std::string& path, uint64_t key,
+        const graph::DirectedWeightedGraph<double>& graph) {
+        std::shared_ptr<const MappedFile> mapped_file;
+        const auto table = LoadTable(path, key, graph, sizeof(TableWeight), mapped_file);
+        if (!table) {
+            return std::nullopt;
+        }
+        return typename graph::Router<double, TableWeight>::TableView{
+            static_cast<const TableWeight*>(table->weights), table->prev_edges, std::move(mapped_file) };
+    }
+
+} // namespace routing_cache
\ No newline at end of file
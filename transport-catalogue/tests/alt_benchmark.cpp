@@ -0,0 +1,75 @@
+// Settled vertices and query time of RouterType::ALT against plain Dijkstra on random stop pairs.
+// Build from transport-catalogue/:
+//   g++ -std=c++17 -O2 -pthread -I. tests/alt_benchmark.cpp $(ls *.cpp | grep -v main.cpp) -o alt_benchmark
+// Usage: alt_benchmark [grid side] [bus count] [query count]
+
+#include "test_network.h"
+#include "transport_router.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+using namespace transport_router;
+
+namespace {
+
+    double GetSecondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    test_network::NetworkSettings network;
+    network.side = argc > 1 ? std::atoi(argv[1]) : 35;
+    network.bus_count = argc > 2 ? std::atoi(argv[2]) : 400;
+    network.max_bus_stops = 30;
+    const int query_count = argc > 3 ? std::atoi(argv[3]) : 2000;
+
+    transport_catalogue::TransportCatalogue catalogue;
+    test_network::FillCatalogue(catalogue, network);
+    const std::vector<std::string_view> stops = test_network::GetStopNames(catalogue);
+    std::mt19937 random(7);
+    std::vector<std::pair<std::string_view, std::string_view>> queries;
+    for (int i = 0; i < query_count; ++i) {
+        queries.push_back({ stops[random() % stops.size()], stops[random() % stops.size()] });
+    }
+
+    RoutingSettings settings;
+    settings.bus_wait_time = 6;
+    settings.bus_velocity = 40.0;
+    settings.router_type = RouterType::DIJKSTRA;
+    const TransportRouter dijkstra(settings, catalogue);
+    const GraphStats stats = dijkstra.GetGraphStats();
+    std::printf("vertices %zu, edges %zu, %d queries\n", stats.vertex_count, stats.edge_count, query_count);
+    std::printf("landmarks  settled (dijkstra -> alt)  query us (dijkstra -> alt)\n");
+
+    for (const size_t landmark_count : { 4, 8, 16 }) {
+        settings.router_type = RouterType::ALT;
+        settings.landmark_count = landmark_count;
+        const TransportRouter alt(settings, catalogue);
+        size_t dijkstra_settled = 0;
+        size_t alt_settled = 0;
+        double dijkstra_seconds = 0.0;
+        double alt_seconds = 0.0;
+        for (const auto& [from, to] : queries) {
+            auto start = std::chrono::steady_clock::now();
+            const auto expected = dijkstra.CalculateOptimalRoute(from, to);
+            dijkstra_seconds += GetSecondsSince(start);
+            dijkstra_settled += graph::DijkstraRouter<double>::GetLastSettledCount();
+
+            start = std::chrono::steady_clock::now();
+            const auto route = alt.CalculateOptimalRoute(from, to);
+            alt_seconds += GetSecondsSince(start);
+            alt_settled += graph::AltRouter<double>::GetLastSettledCount();
+
+            test_network::Check(expected.has_value() == route.has_value()
+                && (!expected || test_network::AreTimesEqual(expected->total_time, route->total_time)),
+                "ALT route differs from Dijkstra between " + std::string(from) + " and " + std::string(to));
+        }
+        std::printf("%9zu  %7zu -> %-16zu  %8.1f -> %.1f\n", landmark_count, dijkstra_settled / queries.size(),
+            alt_settled / queries.size(), dijkstra_seconds / queries.size() * 1e6, alt_seconds / queries.size() * 1e6);
+    }
+}
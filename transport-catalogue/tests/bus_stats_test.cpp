@@ -0,0 +1,164 @@
+// Bus stats of TransportCatalogue: after every random SetDistance, AddBus or Finalize the stats of every bus must equal
+// the stats computed from scratch over a plain map of the set distances. Covers the refresh of the stats computed
+// by Finalize, one-way distances used for the way back, and buses added after Finalize, which are computed on the fly.
+// Build from transport-catalogue/:
+//   g++ -std=c++17 -O2 -pthread -I. tests/bus_stats_test.cpp $(ls *.cpp | grep -v main.cpp) -o bus_stats_test
+
+#include "geo.h"
+#include "test_network.h"
+#include "transport_catalogue.h"
+
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+    const int STOP_COUNT = 40;
+    const int INITIAL_BUS_COUNT = 15;
+    const int STEP_COUNT = 400;
+
+    class BusStatsChecker {
+    public:
+        explicit BusStatsChecker(unsigned seed)
+            : random_(seed) {
+            std::uniform_real_distribution<double> jitter(0.0, 0.05);
+            for (int i = 0; i < STOP_COUNT; ++i) {
+                const std::string name = "S" + std::to_string(i);
+                catalogue_.AddStop(name, { 55.5 + jitter(random_), 37.4 + jitter(random_) });
+                stops_.push_back(catalogue_.FindStop(name));
+            }
+            for (int i = 0; i < INITIAL_BUS_COUNT; ++i) {
+                AddBus();
+            }
+            catalogue_.Finalize();
+        }
+
+        void Run() {
+            for (int step = 0; step < STEP_COUNT; ++step) {
+                const int action = static_cast<int>(random_() % 25);
+                if (action == 0) {
+                    catalogue_.Finalize();
+                }
+                else if (action == 1) {
+                    AddBus();
+                }
+                else {
+                    SetDistances();
+                }
+                CheckAllBuses("step " + std::to_string(step));
+            }
+        }
+
+    private:
+        std::mt19937 random_;
+        transport_catalogue::TransportCatalogue catalogue_;
+        std::vector<domain::Stop*> stops_;
+        std::vector<domain::Bus*> buses_;
+        std::map<std::pair<const domain::Stop*, const domain::Stop*>, int> set_distances_;
+
+        void SetDistance(domain::Stop* from, domain::Stop* to, std::vector<domain::Distance>& distances) {
+            const int distance = 1 + static_cast<int>(random_() % 5000);
+            set_distances_[{ from, to }] = distance;
+            distances.push_back({ from, to, distance });
+        }
+
+        // Random stops, a third of the buses circular and the others there and back as the reader makes them;
+        // a few buses have no stops or a single one
+        void AddBus() {
+            const std::string name = "B" + std::to_string(buses_.size());
+            const bool is_roundtrip = random_() % 3 == 0;
+            const size_t stop_count = random_() % 8 == 0 ? random_() % 2 : 2 + random_() % 8;
+            std::vector<std::string_view> stops;
+            for (size_t i = 0; i < stop_count; ++i) {
+                stops.push_back(stops_[random_() % stops_.size()]->name);
+            }
+            if (is_roundtrip && !stops.empty()) {
+                stops.push_back(stops.front());
+            }
+            else if (!stops.empty()) {
+                stops.insert(stops.end(), std::next(stops.rbegin()), stops.rend());
+            }
+            catalogue_.AddBus(name, is_roundtrip ? domain::BusType::CIRCULAR : domain::BusType::LINEAR);
+            catalogue_.AddStopToBus(stops, name);
+            domain::Bus* bus = catalogue_.FindBus(name);
+            buses_.push_back(bus);
+
+            // Half of the hops only one way, so the way back takes the same distance
+            std::vector<domain::Distance> distances;
+            for (size_t i = 0; i + 1 < bus->stops.size(); ++i) {
+                if (set_distances_.count({ bus->stops[i], bus->stops[i + 1] }) == 0
+                    && set_distances_.count({ bus->stops[i + 1], bus->stops[i] }) == 0) {
+                    SetDistance(bus->stops[i], bus->stops[i + 1], distances);
+                    if (random_() % 2 == 0) {
+                        SetDistance(bus->stops[i + 1], bus->stops[i], distances);
+                    }
+                }
+            }
+            catalogue_.SetDistance(distances);
+        }
+
+        // Hops of the buses, in either direction, and now and then a pair of stops no bus drives between
+        void SetDistances() {
+            std::vector<domain::Distance> distances;
+            const int count = 1 + static_cast<int>(random_() % 3);
+            for (int i = 0; i < count; ++i) {
+                const domain::Bus* bus = buses_[random_() % buses_.size()];
+                if (bus->stops.size() < 2 || random_() % 10 == 0) {
+                    SetDistance(stops_[random_() % stops_.size()], stops_[random_() % stops_.size()], distances);
+                    continue;
+                }
+                const size_t hop = random_() % (bus->stops.size() - 1);
+                const bool is_forward = random_() % 2 == 0;
+                SetDistance(bus->stops[is_forward ? hop : hop + 1], bus->stops[is_forward ? hop + 1 : hop], distances);
+            }
+            catalogue_.SetDistance(distances);
+        }
+
+        int GetExpectedDistance(const domain::Stop* from, const domain::Stop* to) const {
+            if (auto it = set_distances_.find({ from, to }); it != set_distances_.end()) {
+                return it->second;
+            }
+            if (auto it = set_distances_.find({ to, from }); it != set_distances_.end()) {
+                return it->second;
+            }
+            return 0;
+        }
+
+        transport_catalogue::BusStats ComputeExpectedStats(const domain::Bus* bus) const {
+            transport_catalogue::BusStats stats;
+            stats.stop_count = static_cast<int>(bus->stops.size());
+            stats.unique_stop_count = static_cast<int>(std::set<const domain::Stop*>(bus->stops.begin(), bus->stops.end()).size());
+            for (size_t i = 0; i + 1 < bus->stops.size(); ++i) {
+                stats.route_length += GetExpectedDistance(bus->stops[i], bus->stops[i + 1]);
+                stats.geographical_length += geo::ComputeDistance(bus->stops[i]->coordinates, bus->stops[i + 1]->coordinates);
+            }
+            stats.curvature = stats.geographical_length > 0.0 ? stats.route_length / stats.geographical_length : 0.0;
+            return stats;
+        }
+
+        void CheckAllBuses(const std::string& description) const {
+            for (const domain::Bus* bus : buses_) {
+                const transport_catalogue::BusStats expected = ComputeExpectedStats(bus);
+                const transport_catalogue::BusStats stats = catalogue_.GetBusStats(bus);
+                test_network::Check(stats.stop_count == expected.stop_count && stats.unique_stop_count == expected.unique_stop_count
+                    && stats.route_length == expected.route_length
+                    && test_network::AreTimesEqual(stats.geographical_length, expected.geographical_length, 1e-9)
+                    && test_network::AreTimesEqual(stats.curvature, expected.curvature, 1e-9),
+                    description + ": stats of bus " + bus->name + ", route length " + std::to_string(stats.route_length)
+                    + ", expected " + std::to_string(expected.route_length));
+            }
+        }
+    };
+
+} // namespace
+
+int main() {
+    for (unsigned seed = 1; seed <= 5; ++seed) {
+        BusStatsChecker(seed).Run();
+    }
+    std::cout << "bus_stats_test: OK" << std::endl;
+}
\ No newline at end of file
@@ -0,0 +1,125 @@
+// Distance index of TransportCatalogue: after every random SetDistance, Finalize or AddStop every pair of stops
+// must have the distance of a plain map of the set distances, the reverse direction used when one is not set.
+// Covered after Finalize: a known pair patched in place, the reverse of a one-way pair set on its own,
+// a new pair which rebuilds the index and a new stop which drops it.
+// Build from transport-catalogue/:
+//   g++ -std=c++17 -O2 -pthread -I. tests/distance_index_test.cpp $(ls *.cpp | grep -v main.cpp) -o distance_index_test
+
+#include "test_network.h"
+#include "transport_catalogue.h"
+
+#include <map>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+    const int INITIAL_STOP_COUNT = 30;
+    const int STEP_COUNT = 600;
+
+    class DistanceChecker {
+    public:
+        explicit DistanceChecker(unsigned seed)
+            : random_(seed) {
+            for (int i = 0; i < INITIAL_STOP_COUNT; ++i) {
+                AddStop();
+            }
+        }
+
+        void Run() {
+            for (int step = 0; step < STEP_COUNT; ++step) {
+                const int action = static_cast<int>(random_() % 20);
+                if (action == 0) {
+                    catalogue_.Finalize();
+                    is_finalized_ = true;
+                }
+                else if (action == 1) {
+                    AddStop();
+                }
+                else {
+                    SetDistances();
+                }
+                CheckAllPairs("step " + std::to_string(step));
+            }
+            test_network::Check(known_pair_count_ > 0 && own_reverse_count_ > 0 && new_pair_count_ > 0,
+                "every kind of change after Finalize is covered");
+        }
+
+    private:
+        std::mt19937 random_;
+        transport_catalogue::TransportCatalogue catalogue_;
+        std::vector<domain::Stop*> stops_;
+        std::map<std::pair<int, int>, int> set_distances_; // by the positions in stops_
+        bool is_finalized_ = false;
+        int known_pair_count_ = 0;
+        int own_reverse_count_ = 0;
+        int new_pair_count_ = 0;
+
+        void AddStop() {
+            std::uniform_real_distribution<double> jitter(0.0, 0.1);
+            const std::string name = "S" + std::to_string(stops_.size());
+            catalogue_.AddStop(name, { 55.5 + jitter(random_), 37.4 + jitter(random_) });
+            stops_.push_back(catalogue_.FindStop(name));
+        }
+
+        std::pair<int, int> PickPair() {
+            // Mostly pairs which already have a distance one way or the other, to hit the index in place
+            if (!set_distances_.empty() && random_() % 3 != 0) {
+                auto it = std::next(set_distances_.begin(), random_() % set_distances_.size());
+                return random_() % 2 == 0 ? it->first : std::make_pair(it->first.second, it->first.first);
+            }
+            const int stop_count = static_cast<int>(stops_.size());
+            return { static_cast<int>(random_() % stop_count), static_cast<int>(random_() % stop_count) };
+        }
+
+        void SetDistances() {
+            std::vector<domain::Distance> distances;
+            const int count = 1 + static_cast<int>(random_() % 3);
+            for (int i = 0; i < count; ++i) {
+                const auto [from, to] = PickPair();
+                const int distance = 1 + static_cast<int>(random_() % 10000);
+                if (is_finalized_) {
+                    const bool is_forward_set = set_distances_.count({ from, to }) > 0;
+                    const bool is_backward_set = set_distances_.count({ to, from }) > 0;
+                    known_pair_count_ += is_forward_set ? 1 : 0;
+                    own_reverse_count_ += !is_forward_set && is_backward_set ? 1 : 0;
+                    new_pair_count_ += !is_forward_set && !is_backward_set ? 1 : 0;
+                }
+                set_distances_[{ from, to }] = distance;
+                distances.push_back({ stops_[from], stops_[to], distance });
+            }
+            catalogue_.SetDistance(distances);
+        }
+
+        int GetExpectedDistance(int from, int to) const {
+            if (auto it = set_distances_.find({ from, to }); it != set_distances_.end()) {
+                return it->second;
+            }
+            if (auto it = set_distances_.find({ to, from }); it != set_distances_.end()) {
+                return it->second;
+            }
+            return 0;
+        }
+
+        void CheckAllPairs(const std::string& description) const {
+            for (size_t from = 0; from < stops_.size(); ++from) {
+                for (size_t to = 0; to < stops_.size(); ++to) {
+                    const int expected = GetExpectedDistance(static_cast<int>(from), static_cast<int>(to));
+                    const int distance = catalogue_.GetDistance(stops_[from], stops_[to]);
+                    test_network::Check(distance == expected, description + ": distance from " + stops_[from]->name
+                        + " to " + stops_[to]->name + " is " + std::to_string(distance) + ", expected " + std::to_string(expected));
+                }
+            }
+        }
+    };
+
+} // namespace
+
+int main() {
+    for (unsigned seed = 1; seed <= 5; ++seed) {
+        DistanceChecker(seed).Run();
+    }
+    std::cout << "distance_index_test: OK" << std::endl;
+}
\ No newline at end of file
@@ -0,0 +1,107 @@
+// Fixed-point all-pairs tables hold routes of about 298 hours at most: a longer route must not be reported
+// as missing, the router falls back to the float tables instead, at the start and after a live change.
+// Build from transport-catalogue/:
+//   g++ -std=c++17 -O2 -pthread -I. tests/fixed_point_range_test.cpp $(ls *.cpp | grep -v main.cpp) -o fixed_point_range_test
+
+#include "router.h"
+#include "test_network.h"
+#include "transport_router.h"
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace transport_router;
+
+namespace {
+
+    // Hours of the longest route the uint32_t tables hold
+    const double RANGE_HOURS = graph::WeightTraits<uint32_t>::INFINITE_WEIGHT / graph::WeightTraits<uint32_t>::SCALE / 60.0;
+
+    void TestGraphRouter() {
+        // Two edges within the range, the route over both of them is not
+        graph::DirectedWeightedGraph<double> graph(3);
+        graph.AddEdge({ 0, 1, RANGE_HOURS * 60.0 * 0.6, "", 0, graph::ItemsType::BUS });
+        graph.AddEdge({ 1, 2, RANGE_HOURS * 60.0 * 0.6, "", 0, graph::ItemsType::BUS });
+        thread_pool::ThreadPool pool;
+        bool is_thrown = false;
+        try {
+            graph::Router<double, uint32_t> router(graph, pool);
+        }
+        catch (const std::overflow_error&) {
+            is_thrown = true;
+        }
+        test_network::Check(is_thrown, "fixed-point router over a route longer than the range");
+
+        const graph::Router<double, float> float_router(graph, pool);
+        test_network::Check(float_router.BuildRoute(0, 2).has_value(), "float router over the same route");
+    }
+
+    void CheckRoutes(const TransportRouter& router, const TransportRouter& expected_router,
+        const std::vector<std::string_view>& stops, const std::string& description) {
+        size_t long_route_count = 0;
+        for (const std::string_view from : stops) {
+            for (const std::string_view to : stops) {
+                const auto expected = expected_router.CalculateOptimalRoute(from, to);
+                const auto route = router.CalculateOptimalRoute(from, to);
+                test_network::Check(expected.has_value() == route.has_value()
+                    && (!expected || test_network::AreTimesEqual(expected->total_time, route->total_time, 1e-3)),
+                    description + ": route from " + std::string(from) + " to " + std::string(to));
+                long_route_count += expected && expected->total_time > RANGE_HOURS * 60.0 ? 1 : 0;
+            }
+        }
+        test_network::Check(long_route_count > 0, description + ": no route longer than the range");
+    }
+
+    // Buses so slow that a ride between neighbouring stops takes hours
+    void TestSlowNetwork() {
+        transport_catalogue::TransportCatalogue catalogue;
+        test_network::FillCatalogue(catalogue, {});
+        RoutingSettings settings;
+        settings.bus_wait_time = 6;
+        settings.bus_velocity = 0.02;
+        settings.use_fixed_point_tables = true;
+        const TransportRouter router(settings, catalogue);
+
+        settings.router_type = RouterType::DIJKSTRA;
+        const TransportRouter expected_router(settings, catalogue);
+        CheckRoutes(router, expected_router, test_network::GetStopNames(catalogue), "slow buses");
+    }
+
+    // A road becomes so long that the route over it does not fit any more
+    void TestLongRoad() {
+        transport_catalogue::TransportCatalogue catalogue;
+        catalogue.AddStop("A", { 55.60, 37.60 });
+        catalogue.AddStop("B", { 55.61, 37.60 });
+        catalogue.AddStop("C", { 55.62, 37.60 });
+        domain::Stop* a = catalogue.FindStop("A");
+        domain::Stop* b = catalogue.FindStop("B");
+        domain::Stop* c = catalogue.FindStop("C");
+        catalogue.SetDistance({ domain::Distance{ a, b, 1500 }, domain::Distance{ b, c, 1500 } });
+        catalogue.AddBus("1", domain::BusType::LINEAR);
+        catalogue.AddStopToBus({ "A", "B", "C", "B", "A" }, "1");
+        catalogue.Finalize();
+
+        RoutingSettings settings;
+        settings.bus_wait_time = 6;
+        settings.bus_velocity = 30.0;
+        settings.use_fixed_point_tables = true;
+        TransportRouter router(settings, catalogue);
+
+        // 500 meters a minute, so twice the range in meters takes twice the range in time
+        catalogue.SetDistance({ domain::Distance{ a, b, static_cast<int>(RANGE_HOURS * 60.0 * 500.0 * 2.0) } });
+        router.UpdateDistance("A", "B");
+
+        settings.router_type = RouterType::DIJKSTRA;
+        const TransportRouter expected_router(settings, catalogue);
+        CheckRoutes(router, expected_router, test_network::GetStopNames(catalogue), "long road");
+    }
+
+} // namespace
+
+int main() {
+    TestGraphRouter();
+    TestSlowNetwork();
+    TestLongRoad();
+    std::cout << "fixed_point_range_test: OK" << std::endl;
+}
@@ -0,0 +1,92 @@
+// Locality of the routing graph with the stops numbered by the names and along the Hilbert curve
+// (RoutingSettings::use_hilbert_order), with the query time of the on-demand routers.
+// Without hardware counters the cache behaviour is estimated from the vertex ids an edge joins: the search reads
+// the per-vertex arrays at both ends, so an edge whose ends are close in the numbering stays in the same cache line
+// or memory page. The stop names are random, as in real data, so the name order is not geographic.
+// Build from transport-catalogue/:
+//   g++ -std=c++17 -O2 -pthread -I. tests/hilbert_locality_benchmark.cpp $(ls *.cpp | grep -v main.cpp) -o hilbert_locality_benchmark
+// Usage: hilbert_locality_benchmark [grid side] [bus count] [query count]
+
+#include "test_network.h"
+#include "transport_router.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+using namespace transport_router;
+
+namespace {
+
+    // Per-vertex entries of 8 bytes: 8 of them in a 64-byte cache line, 512 in a 4 KiB page
+    const size_t VERTICES_PER_LINE = 8;
+    const size_t VERTICES_PER_PAGE = 512;
+
+    void PrintLocality(const char* description, const TransportRouter& router) {
+        const auto& graph = router.GetGraph();
+        size_t same_line = 0;
+        size_t same_page = 0;
+        double log_gap_sum = 0.0;
+        for (graph::EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+            const auto& edge = graph.GetEdge(edge_id);
+            same_line += edge.from / VERTICES_PER_LINE == edge.to / VERTICES_PER_LINE;
+            same_page += edge.from / VERTICES_PER_PAGE == edge.to / VERTICES_PER_PAGE;
+            const double gap = edge.from > edge.to ? edge.from - edge.to : edge.to - edge.from;
+            log_gap_sum += std::log2(1.0 + gap);
+        }
+        const double edge_count = static_cast<double>(graph.GetEdgeCount());
+        std::printf("%-14s edges in one line %5.1f%%, in one page %5.1f%%, mean log2 id gap %5.2f\n", description,
+            100.0 * same_line / edge_count, 100.0 * same_page / edge_count, log_gap_sum / edge_count);
+    }
+
+    double MeasureQueries(const TransportRouter& router, const std::vector<std::pair<std::string_view, std::string_view>>& queries) {
+        const auto start = std::chrono::steady_clock::now();
+        for (const auto& [from, to] : queries) {
+            router.CalculateOptimalRoute(from, to);
+        }
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    test_network::NetworkSettings network;
+    network.side = argc > 1 ? std::atoi(argv[1]) : 120;
+    network.bus_count = argc > 2 ? std::atoi(argv[2]) : 1500;
+    network.max_bus_stops = 40;
+    network.use_random_names = true;
+    const int query_count = argc > 3 ? std::atoi(argv[3]) : 300;
+
+    transport_catalogue::TransportCatalogue catalogue;
+    test_network::FillCatalogue(catalogue, network);
+    const std::vector<std::string_view> stops = test_network::GetStopNames(catalogue);
+    std::mt19937 random(3);
+    std::vector<std::pair<std::string_view, std::string_view>> queries;
+    for (int i = 0; i < query_count; ++i) {
+        queries.push_back({ stops[random() % stops.size()], stops[random() % stops.size()] });
+    }
+
+    const std::pair<const char*, GraphModel> graph_models[] = {
+        { "stop_pairs", GraphModel::STOP_PAIRS },
+        { "riding", GraphModel::RIDING },
+    };
+    for (const auto& [model_name, graph_model] : graph_models) {
+        for (const RouterType router_type : { RouterType::DIJKSTRA, RouterType::ALT }) {
+            std::printf("%s, %s, %d queries\n", model_name, router_type == RouterType::DIJKSTRA ? "dijkstra" : "alt", query_count);
+            for (const bool use_hilbert_order : { false, true }) {
+                RoutingSettings settings;
+                settings.bus_wait_time = 6;
+                settings.bus_velocity = 30.0;
+                settings.graph_model = graph_model;
+                settings.router_type = router_type;
+                settings.use_hilbert_order = use_hilbert_order;
+                const TransportRouter router(settings, catalogue);
+                const char* order = use_hilbert_order ? "hilbert order" : "name order";
+                PrintLocality(order, router);
+                std::printf("%-14s queries %.2f s\n", order, MeasureQueries(router, queries));
+            }
+        }
+    }
+}
@@ -0,0 +1,76 @@
+// RoutingSettings::use_hilbert_order only renumbers the vertices: every router on every graph model must find routes
+// of the same time as with the stops numbered by the names. Equal-time routes may differ in their items.
+// Build from transport-catalogue/:
+//   g++ -std=c++17 -O2 -pthread -I. tests/hilbert_order_test.cpp $(ls *.cpp | grep -v main.cpp) -o hilbert_order_test
+
+#include "test_network.h"
+#include "transport_router.h"
+
+#include <random>
+#include <string>
+
+using namespace transport_router;
+
+namespace {
+
+    const int QUERY_COUNT = 300;
+
+    void TestSameRoutes(const transport_catalogue::TransportCatalogue& catalogue, RoutingSettings settings,
+        const std::string& description) {
+        settings.use_hilbert_order = false;
+        const TransportRouter by_names(settings, catalogue);
+        settings.use_hilbert_order = true;
+        const TransportRouter by_curve(settings, catalogue);
+
+        const std::vector<std::string_view> stops = test_network::GetStopNames(catalogue);
+        std::mt19937 random(5);
+        for (int query = 0; query < QUERY_COUNT; ++query) {
+            const std::string_view from = stops[random() % stops.size()];
+            const std::string_view to = stops[random() % stops.size()];
+            const auto expected = by_names.CalculateOptimalRoute(from, to);
+            const auto route = by_curve.CalculateOptimalRoute(from, to);
+            test_network::Check(expected.has_value() == route.has_value()
+                && (!expected || test_network::AreTimesEqual(expected->total_time, route->total_time)),
+                description + ": route from " + std::string(from) + " to " + std::string(to));
+        }
+
+        const std::string_view from = stops[random() % stops.size()];
+        const auto expected = by_names.CalculateReachableStops(from, 30.0);
+        const auto reachable = by_curve.CalculateReachableStops(from, 30.0);
+        test_network::Check(expected.size() == reachable.size(), description + ": reachable stops from " + std::string(from));
+    }
+
+} // namespace
+
+int main() {
+    transport_catalogue::TransportCatalogue catalogue;
+    test_network::FillCatalogue(catalogue, { 12, 40, 14, 9 });
+
+    const std::pair<std::string, RouterType> router_types[] = {
+        { "all_pairs", RouterType::ALL_PAIRS },
+        { "dijkstra", RouterType::DIJKSTRA },
+        { "contraction_hierarchy", RouterType::CONTRACTION_HIERARCHY },
+        { "alt", RouterType::ALT },
+        { "raptor", RouterType::RAPTOR },
+        { "partition", RouterType::PARTITION },
+    };
+    const std::pair<std::string, GraphModel> graph_models[] = {
+        { "stop_pairs", GraphModel::STOP_PAIRS },
+        { "riding", GraphModel::RIDING },
+        { "collapsed", GraphModel::COLLAPSED },
+    };
+    for (const auto& [router_name, router_type] : router_types) {
+        for (const auto& [model_name, graph_model] : graph_models) {
+            RoutingSettings settings;
+            settings.bus_wait_time = 6;
+            settings.bus_velocity = 30.0;
+            settings.router_type = router_type;
+            settings.graph_model = graph_model;
+            settings.partition_cell_size = 16;
+            TestSameRoutes(catalogue, settings, router_name + " on " + model_name);
+            settings.walk_radius = 400.0;
+            TestSameRoutes(catalogue, settings, router_name + " on " + model_name + " with walks");
+        }
+    }
+    std::cout << "hilbert_order_test: OK" << std::endl;
+}
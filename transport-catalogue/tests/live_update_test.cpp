@@ -0,0 +1,146 @@
+// Live updates of TransportRouter: after every random change of a distance, a stop or a bus, the routers updated
+// in place must answer as a router built from scratch on the changed network.
+// Build from transport-catalogue/:
+//   g++ -std=c++17 -O2 -pthread -I. tests/live_update_test.cpp $(ls *.cpp | grep -v main.cpp) -o live_update_test
+
+#include "test_network.h"
+#include "transport_router.h"
+
+#include <memory>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace transport_router;
+
+namespace {
+
+    const int STEP_COUNT = 40;
+    const int QUERIES_PER_STEP = 20;
+
+    struct TestedRouter {
+        std::string name;
+        std::unique_ptr<TransportRouter> router;
+    };
+
+    std::vector<TestedRouter> CreateRouters(const RoutingSettings& base, const transport_catalogue::TransportCatalogue& catalogue) {
+        const std::pair<std::string, RouterType> router_types[] = {
+            { "all_pairs", RouterType::ALL_PAIRS },
+            { "dijkstra", RouterType::DIJKSTRA },
+            { "contraction_hierarchy", RouterType::CONTRACTION_HIERARCHY },
+            { "alt", RouterType::ALT },
+            { "raptor", RouterType::RAPTOR },
+            { "partition", RouterType::PARTITION },
+        };
+        std::vector<TestedRouter> routers;
+        for (const auto& [name, router_type] : router_types) {
+            RoutingSettings settings = base;
+            settings.router_type = router_type;
+            routers.push_back({ name, std::make_unique<TransportRouter>(settings, catalogue) });
+        }
+        RoutingSettings settings = base;
+        settings.router_type = RouterType::PARTITION;
+        settings.partition_cell_size = 3;
+        routers.push_back({ "partition of small cells", std::make_unique<TransportRouter>(settings, catalogue) });
+        settings = base;
+        settings.use_compact_tables = true;
+        routers.push_back({ "all_pairs float", std::make_unique<TransportRouter>(settings, catalogue) });
+        settings = base;
+        settings.use_fixed_point_tables = true;
+        routers.push_back({ "all_pairs fixed point", std::make_unique<TransportRouter>(settings, catalogue) });
+        return routers;
+    }
+
+    void TestLiveUpdates(const RoutingSettings& base, const std::string& description) {
+        transport_catalogue::TransportCatalogue catalogue;
+        test_network::FillCatalogue(catalogue, { 8, 20, 10, 3 });
+        const std::vector<std::string_view> stops = test_network::GetStopNames(catalogue);
+        const std::vector<std::string_view> buses = test_network::GetBusNames(catalogue);
+        std::vector<TestedRouter> routers = CreateRouters(base, catalogue);
+        std::set<std::string_view> disabled_stops;
+        std::set<std::string_view> disabled_buses;
+        std::mt19937 random(11);
+
+        for (int step = 0; step < STEP_COUNT; ++step) {
+            const unsigned kind = random() % 4;
+            if (kind <= 1) {
+                // A road gets shorter or longer
+                const domain::Bus* bus = catalogue.FindBus(buses[random() % buses.size()]);
+                const size_t i = random() % (bus->stops.size() - 1);
+                domain::Stop* from = bus->stops[i];
+                domain::Stop* to = bus->stops[i + 1];
+                const int distance = catalogue.GetDistance(from, to);
+                catalogue.SetDistance({ domain::Distance{ from, to, kind == 0 ? std::max(1, distance / 3) : distance * 3 + 100 } });
+                for (auto& tested : routers) {
+                    tested.router->UpdateDistance(from->name, to->name);
+                }
+            }
+            else if (kind == 2) {
+                const std::string_view stop = stops[random() % stops.size()];
+                const bool is_enabled = disabled_stops.count(stop) > 0;
+                is_enabled ? disabled_stops.erase(stop) : disabled_stops.insert(stop).second;
+                for (auto& tested : routers) {
+                    tested.router->SetStopEnabled(stop, is_enabled);
+                }
+            }
+            else {
+                const std::string_view bus = buses[random() % buses.size()];
+                const bool is_enabled = disabled_buses.count(bus) > 0;
+                is_enabled ? disabled_buses.erase(bus) : disabled_buses.insert(bus).second;
+                for (auto& tested : routers) {
+                    tested.router->SetBusEnabled(bus, is_enabled);
+                }
+            }
+
+            RoutingSettings settings = base;
+            settings.router_type = RouterType::DIJKSTRA;
+            settings.prune_parallel_edges = false;
+            TransportRouter expected_router(settings, catalogue);
+            for (const std::string_view stop : disabled_stops) {
+                expected_router.SetStopEnabled(stop, false);
+            }
+            for (const std::string_view bus : disabled_buses) {
+                expected_router.SetBusEnabled(bus, false);
+            }
+            for (int query = 0; query < QUERIES_PER_STEP; ++query) {
+                const std::string_view from = stops[random() % stops.size()];
+                const std::string_view to = stops[random() % stops.size()];
+                const auto expected = expected_router.CalculateOptimalRoute(from, to);
+                for (const auto& tested : routers) {
+                    const auto route = tested.router->CalculateOptimalRoute(from, to);
+                    // Milliseconds of the fixed point tables are rounded
+                    const double tolerance = tested.name == "all_pairs fixed point" ? 1e-3 : 1e-6;
+                    test_network::Check(expected.has_value() == route.has_value()
+                        && (!expected || test_network::AreTimesEqual(expected->total_time, route->total_time, tolerance)),
+                        description + ", " + tested.name + " after step " + std::to_string(step) + ": route from "
+                        + std::string(from) + " to " + std::string(to));
+                }
+            }
+        }
+    }
+
+} // namespace
+
+int main() {
+    const std::pair<std::string, GraphModel> graph_models[] = {
+        { "stop_pairs", GraphModel::STOP_PAIRS },
+        { "riding", GraphModel::RIDING },
+        { "collapsed", GraphModel::COLLAPSED },
+    };
+    for (const auto& [model_name, graph_model] : graph_models) {
+        for (const bool prune_parallel_edges : { false, true }) {
+            for (const double walk_radius : { 0.0, 500.0 }) {
+                RoutingSettings settings;
+                settings.bus_wait_time = 6;
+                settings.bus_velocity = 30.0;
+                settings.graph_model = graph_model;
+                settings.prune_parallel_edges = prune_parallel_edges;
+                settings.walk_radius = walk_radius;
+                TestLiveUpdates(settings, model_name + (prune_parallel_edges ? " pruned" : "")
+                    + (walk_radius > 0.0 ? " with walks" : ""));
+            }
+        }
+    }
+    std::cout << "live_update_test: OK" << std::endl;
+}
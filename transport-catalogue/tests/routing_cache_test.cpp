@@ -0,0 +1,186 @@
+// Routing cache: the tables read back from the file give the same routes as the computed ones, a file of another
+// key, table type or graph, or a cut file, is rejected, and no temporary file is left behind.
+// TransportRouter loads the tables instead of computing them and does not write them again on live changes.
+// Build from transport-catalogue/:
+//   g++ -std=c++17 -O2 -pthread -I. tests/routing_cache_test.cpp $(ls *.cpp | grep -v main.cpp) -o routing_cache_test
+
+#include "routing_cache.h"
+#include "test_network.h"
+#include "transport_router.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace transport_router;
+
+namespace {
+
+    const uint64_t CACHE_KEY = 42;
+
+    std::filesystem::path CreateTestDirectory() {
+        std::random_device random_device;
+        const std::filesystem::path directory = std::filesystem::temp_directory_path()
+            / ("routing_cache_test_" + std::to_string(random_device()));
+        std::filesystem::create_directories(directory);
+        return directory;
+    }
+
+    std::vector<std::string> GetFileNames(const std::filesystem::path& directory) {
+        std::vector<std::string> names;
+        for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+            names.push_back(entry.path().filename().string());
+        }
+        std::sort(names.begin(), names.end());
+        return names;
+    }
+
+    std::string ReadFile(const std::filesystem::path& path) {
+        std::ifstream input(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+    }
+
+    void WriteFile(const std::filesystem::path& path, const std::string& content) {
+        std::ofstream output(path, std::ios::binary | std::ios::trunc);
+        output.write(content.data(), content.size());
+    }
+
+    template <typename TableWeight>
+    void CheckSameRoutes(const graph::Router<double, TableWeight>& expected_router, const graph::Router<double, TableWeight>& router,
+        size_t vertex_count, const std::string& description) {
+        for (graph::VertexId from = 0; from < vertex_count; ++from) {
+            for (graph::VertexId to = 0; to < vertex_count; ++to) {
+                const auto expected = expected_router.BuildRoute(from, to);
+                const auto route = router.BuildRoute(from, to);
+                test_network::Check(expected.has_value() == route.has_value()
+                    && (!expected || (expected->weight == route->weight && expected->edges == route->edges)),
+                    description + ": route from " + std::to_string(from) + " to " + std::to_string(to));
+            }
+        }
+    }
+
+    template <typename TableWeight>
+    void TestTableFile(const graph::DirectedWeightedGraph<double>& graph, const std::filesystem::path& directory,
+        const std::string& description) {
+        const std::string path = (directory / (description + ".bin")).string();
+        thread_pool::ThreadPool pool;
+        const graph::Router<double, TableWeight> router(graph, pool);
+        test_network::Check(routing_cache::SaveRouterTable(path, CACHE_KEY, graph, router), description + ": save");
+        test_network::Check(GetFileNames(directory) == std::vector<std::string>{ description + ".bin" },
+            description + ": only the cache file in the directory after the save");
+
+        auto table = routing_cache::LoadRouterTable<TableWeight>(path, CACHE_KEY, graph);
+        test_network::Check(table.has_value(), description + ": load");
+        const graph::Router<double, TableWeight> loaded_router(graph, std::move(*table), pool);
+        CheckSameRoutes(router, loaded_router, graph.GetVertexCount(), description + " loaded");
+
+        test_network::Check(!routing_cache::LoadRouterTable<TableWeight>(path, CACHE_KEY + 1, graph),
+            description + ": another key is rejected");
+
+        graph::DirectedWeightedGraph<double> changed_graph = graph;
+        changed_graph.SetEdgeWeight(0, graph.GetEdge(0).weight + 1.0);
+        test_network::Check(!routing_cache::LoadRouterTable<TableWeight>(path, CACHE_KEY, changed_graph),
+            description + ": a changed edge weight is rejected");
+
+        graph::DirectedWeightedGraph<double> extended_graph = graph;
+        extended_graph.AddEdge({ 0, 1, 1.0, "", 0, graph::ItemsType::BUS });
+        test_network::Check(!routing_cache::LoadRouterTable<TableWeight>(path, CACHE_KEY, extended_graph),
+            description + ": an added edge is rejected");
+
+        const std::string content = ReadFile(path);
+        const std::string cut_path = (directory / "cut.bin").string();
+        for (const size_t cut_size : { size_t(0), size_t(16), content.size() / 2, content.size() - 1 }) {
+            WriteFile(cut_path, content.substr(0, cut_size));
+            test_network::Check(!routing_cache::LoadRouterTable<TableWeight>(cut_path, CACHE_KEY, graph),
+                description + ": a file cut to " + std::to_string(cut_size) + " bytes is rejected");
+        }
+        std::filesystem::remove(cut_path);
+        std::filesystem::remove(path);
+    }
+
+    void TestTableFiles(const std::filesystem::path& directory) {
+        transport_catalogue::TransportCatalogue catalogue;
+        test_network::FillCatalogue(catalogue, { 6, 12, 8, 3 });
+        RoutingSettings settings;
+        settings.bus_wait_time = 6;
+        settings.bus_velocity = 30.0;
+        settings.router_type = RouterType::DIJKSTRA;
+        const TransportRouter transport_router(settings, catalogue);
+        const graph::DirectedWeightedGraph<double>& graph = transport_router.GetGraph();
+
+        TestTableFile<double>(graph, directory, "double");
+        TestTableFile<float>(graph, directory, "float");
+        TestTableFile<uint32_t>(graph, directory, "fixed_point");
+
+        const std::string path = (directory / "double.bin").string();
+        thread_pool::ThreadPool pool;
+        const graph::Router<double, double> router(graph, pool);
+        routing_cache::SaveRouterTable(path, CACHE_KEY, graph, router);
+        test_network::Check(!routing_cache::LoadRouterTable<float>(path, CACHE_KEY, graph),
+            "a table of another weight type is rejected");
+        std::filesystem::remove(path);
+
+        const std::string missing_path = (directory / "missing" / "double.bin").string();
+        test_network::Check(!routing_cache::SaveRouterTable(missing_path, CACHE_KEY, graph, router),
+            "a save into a missing directory fails");
+        test_network::Check(GetFileNames(directory).empty(), "nothing is left behind");
+    }
+
+    void TestTransportRouter(const std::filesystem::path& directory) {
+        transport_catalogue::TransportCatalogue catalogue;
+        test_network::FillCatalogue(catalogue, {});
+        const std::vector<std::string_view> stops = test_network::GetStopNames(catalogue);
+        RoutingSettings settings;
+        settings.bus_wait_time = 6;
+        settings.bus_velocity = 30.0;
+        settings.prune_parallel_edges = true;
+        const TransportRouter expected_router(settings, catalogue);
+
+        settings.cache_path = (directory / "router.bin").string();
+        const TransportRouter saving_router(settings, catalogue);
+        test_network::Check(GetFileNames(directory) == std::vector<std::string>{ "router.bin" },
+            "the router saves its tables");
+        const auto saved_time = std::filesystem::last_write_time(settings.cache_path);
+        const std::string saved_content = ReadFile(settings.cache_path);
+
+        // A router which computed its tables again would replace the file
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        TransportRouter loading_router(settings, catalogue);
+        test_network::Check(std::filesystem::last_write_time(settings.cache_path) == saved_time,
+            "the router loads the saved tables");
+        for (const std::string_view from : stops) {
+            for (const std::string_view to : stops) {
+                const auto expected = expected_router.CalculateOptimalRoute(from, to);
+                const auto route = loading_router.CalculateOptimalRoute(from, to);
+                test_network::Check(expected.has_value() == route.has_value()
+                    && (!expected || test_network::AreTimesEqual(expected->total_time, route->total_time)),
+                    "router over the loaded tables: route from " + std::string(from) + " to " + std::string(to));
+            }
+        }
+
+        // With pruned edges every closure rebuilds the graph and the tables, they must not replace the cache
+        loading_router.SetStopEnabled(stops[stops.size() / 2], false);
+        loading_router.SetBusEnabled(test_network::GetBusNames(catalogue).front(), false);
+        loading_router.SetStopEnabled(stops[stops.size() / 2], true);
+        test_network::Check(ReadFile(settings.cache_path) == saved_content
+            && std::filesystem::last_write_time(settings.cache_path) == saved_time,
+            "the cache is not written on live changes");
+        test_network::Check(GetFileNames(directory) == std::vector<std::string>{ "router.bin" },
+            "no temporary files after the live changes");
+        std::filesystem::remove(settings.cache_path);
+    }
+
+} // namespace
+
+int main() {
+    const std::filesystem::path directory = CreateTestDirectory();
+    TestTableFiles(directory);
+    TestTransportRouter(directory);
+    std::filesystem::remove_all(directory);
+    std::cout << "routing_cache_test: OK" << std::endl;
+}
\ No newline at end of file
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "geo.h"
+#include "transport_catalogue.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Random networks for the tests and the benchmarks: the stops are on a jittered side x side grid
+// and every bus drives between neighbouring stops, so the network looks like a city
+namespace test_network {
+
+    struct NetworkSettings {
+        int side = 10;
+        int bus_count = 30;
+        int max_bus_stops = 12;
+        unsigned seed = 1;
+        bool use_random_names = false; // names unrelated to the position, so the name order is not geographic
+    };
+
+    inline void FillCatalogue(transport_catalogue::TransportCatalogue& catalogue, const NetworkSettings& settings) {
+        std::mt19937 random(settings.seed);
+        std::uniform_real_distribution<double> jitter(0.0, 1.0);
+        std::vector<int> name_numbers(settings.side * settings.side);
+        for (size_t k = 0; k < name_numbers.size(); ++k) {
+            name_numbers[k] = static_cast<int>(k);
+        }
+        if (settings.use_random_names) {
+            std::shuffle(name_numbers.begin(), name_numbers.end(), random);
+        }
+        const auto get_stop_name = [&](int i, int j) {
+            return settings.use_random_names ? "S" + std::to_string(name_numbers[i * settings.side + j])
+                : "S" + std::to_string(i) + "_" + std::to_string(j);
+        };
+        for (int i = 0; i < settings.side; ++i) {
+            for (int j = 0; j < settings.side; ++j) {
+                catalogue.AddStop(get_stop_name(i, j),
+                    { 55.5 + i * 0.004 + jitter(random) * 0.002, 37.4 + j * 0.006 + jitter(random) * 0.003 });
+            }
+        }
+
+        const int steps[4][2] = { { 0, 1 }, { 1, 0 }, { 0, -1 }, { -1, 0 } };
+        for (int bus = 0; bus < settings.bus_count; ++bus) {
+            const std::string bus_name = "B" + std::to_string(bus);
+            int i = static_cast<int>(random() % settings.side);
+            int j = static_cast<int>(random() % settings.side);
+            int direction = static_cast<int>(random() % 4);
+            std::vector<std::string> stop_names{ get_stop_name(i, j) };
+            const int stop_count = 3 + static_cast<int>(random() % std::max(1, settings.max_bus_stops - 2));
+            while (static_cast<int>(stop_names.size()) < stop_count) {
+                if (random() % 4 == 0) {
+                    direction = static_cast<int>(random() % 4);
+                }
+                int next_i = i + steps[direction][0];
+                int next_j = j + steps[direction][1];
+                if (next_i < 0 || next_i >= settings.side || next_j < 0 || next_j >= settings.side) {
+                    direction = (direction + 2) % 4;
+                    next_i = i + steps[direction][0];
+                    next_j = j + steps[direction][1];
+                }
+                i = next_i;
+                j = next_j;
+                stop_names.push_back(get_stop_name(i, j));
+            }
+
+            const bool is_roundtrip = random() % 3 == 0;
+            std::vector<std::string_view> stops(stop_names.begin(), stop_names.end());
+            if (is_roundtrip) {
+                stops.push_back(stops.front());
+            }
+            else {
+                stops.insert(stops.end(), std::next(stops.rbegin()), stops.rend());
+            }
+            // Roads are longer than the straight line, a third of them by a different length back
+            for (size_t k = 0; k + 1 < stops.size(); ++k) {
+                domain::Stop* from = catalogue.FindStop(stops[k]);
+                domain::Stop* to = catalogue.FindStop(stops[k + 1]);
+                const double straight = geo::ComputeDistance(from->coordinates, to->coordinates);
+                catalogue.SetDistance({ domain::Distance{ from, to, static_cast<int>(straight * (1.1 + jitter(random) * 0.5)) } });
+                if (random() % 3 == 0) {
+                    catalogue.SetDistance({ domain::Distance{ to, from, static_cast<int>(straight * (1.1 + jitter(random) * 0.5)) } });
+                }
+            }
+            catalogue.AddBus(bus_name, is_roundtrip ? domain::BusType::CIRCULAR : domain::BusType::LINEAR);
+            catalogue.AddStopToBus(stops, bus_name);
+        }
+        catalogue.Finalize();
+    }
+
+    inline std::vector<std::string_view> GetStopNames(const transport_catalogue::TransportCatalogue& catalogue) {
+        std::vector<std::string_view> names;
+        for (const auto& [stop_name, stop_ptr] : catalogue.GetSortedStops()) {
+            names.push_back(stop_name);
+        }
+        return names;
+    }
+
+    inline std::vector<std::string_view> GetBusNames(const transport_catalogue::TransportCatalogue& catalogue) {
+        std::vector<std::string_view> names;
+        for (const auto& [bus_name, bus_ptr] : catalogue.GetSortedBuses()) {
+            names.push_back(bus_name);
+        }
+        return names;
+    }
+
+    // Prints the failed check and exits with an error, so that a test stops at the first broken expectation
+    inline void Check(bool condition, const std::string& message) {
+        if (!condition) {
+            std::cerr << "FAILED: " << message << std::endl;
+            std::exit(1);
+        }
+    }
+
+    inline bool AreTimesEqual(double lhs, double rhs, double tolerance = 1e-6) {
+        return std::abs(lhs - rhs) <= tolerance * std::max(1.0, std::abs(lhs));
+    }
+
+} // namespace test_network
@@ -0,0 +1,100 @@
+#include "thread_pool.h"
+
+namespace thread_pool {
+
+    ThreadPool::ThreadPool(size_t thread_count) {
+        for (size_t i = 1; i < thread_count; ++i) {
+            workers_.emplace_back([this] { WorkerLoop(); });
+        }
+    }
+
+    ThreadPool::~ThreadPool() {
+        {
+            std::lock_guard lock(mutex_);
+            stopping_ = true;
+        }
+        work_ready_.notify_all();
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    size_t ThreadPool::GetThreadCount() const {
+        return workers_.size() + 1;
+    }
+
+    size_t ThreadPool::GetDefaultThreadCount() {
+        const size_t hardware_threads = std::thread::hardware_concurrency();
+        return hardware_threads == 0 ? 1 : hardware_threads;
+    }
+
+    void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t)>& task) {
+        if (count == 0) {
+            return;
+        }
+        if (workers_.empty() || count == 1) {
+            for (size_t index = 0; index < count; ++index) {
+                task(index);
+            }
+            return;
+        }
+
+        std::lock_guard parallel_for_lock(parallel_for_mutex_);
+        {
+            std::lock_guard lock(mutex_);
+            task_ = &task;
+            task_count_ = count;
+            next_index_ = 0;
+            active_workers_ = workers_.size();
+            exception_ = nullptr;
+            ++generation_;
+        }
+        work_ready_.notify_all();
+
+        RunTasks();
+
+        std::unique_lock lock(mutex_);
+        work_done_.wait(lock, [this] { return active_workers_ == 0; });
+        task_ = nullptr;
+        if (exception_) {
+            std::rethrow_exception(exception_);
+        }
+    }
+
+    void ThreadPool::WorkerLoop() {
+        size_t seen_generation = 0;
+        while (true) {
+            {
+                std::unique_lock lock(mutex_);
+                work_ready_.wait(lock, [&] { return stopping_ || generation_ != seen_generation; });
+                if (stopping_) {
+                    return;
+                }
+                seen_generation = generation_;
+            }
+
+            RunTasks();
+
+            {
+                std::lock_guard lock(mutex_);
+                --active_workers_;
+            }
+            work_done_.notify_one();
+        }
+    }
+
+    void ThreadPool::RunTasks() {
+        for (size_t index = next_index_++; index < task_count_; index = next_index_++) {
+            try {
+                (*task_)(index);
+            }
+            catch (...) {
+                std::lock_guard lock(mutex_);
+                if (!exception_) {
+                    exception_ = std::current_exception();
+                }
+            }
+        }
+    }
+
+} // namespace thread_pool
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace thread_pool {
+
+    // Fixed set of worker threads executing index ranges in parallel.
+    // The calling thread takes part in the work, so a pool of one thread runs everything inline.
+    class ThreadPool {
+    public:
+        explicit ThreadPool(size_t thread_count = GetDefaultThreadCount());
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        size_t GetThreadCount() const;
+
+        // Calls task(index) for every index in [0, count) and waits until all calls have finished.
+        // The first exception thrown by a task is rethrown to the caller. Calls from several threads run one after another.
+        void ParallelFor(size_t count, const std::function<void(size_t)>& task);
+
+        static size_t GetDefaultThreadCount();
+
+    private:
+        void WorkerLoop();
+        void RunTasks();
+
+        std::vector<std::thread> workers_;
+        std::mutex parallel_for_mutex_;
+        std::mutex mutex_;
+        std::condition_variable work_ready_;
+        std::condition_variable work_done_;
+
+        const std::function<void(size_t)>* task_ = nullptr;
+        size_t task_count_ = 0;
+        std::atomic<size_t> next_index_{ 0 };
+        size_t active_workers_ = 0;
+        size_t generation_ = 0;
+        std::exception_ptr exception_;
+        bool stopping_ = false;
+    };
+
+} // namespace thread_pool
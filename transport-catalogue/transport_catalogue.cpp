@@ -4,10 +4,15 @@ namespace transport_catalogue {
 
 	void TransportCatalogue::AddStop(std::string_view stop_name, geo::Coordinates coordinates) {
 		domain::Stop stop;
+		stop.id = static_cast<uint32_t>(stops_.size());
 		stop.name = stop_name;
 		stop.coordinates = coordinates;
 		stops_.push_back(std::move(stop));
 		stopname_to_stop_.insert({ stops_.back().name, &stops_.back() });
+		// The index has no row for the new stop until the next Finalize
+		if (are_distances_indexed_) {
+			RestoreDistances();
+		}
 	}
 
 	void TransportCatalogue::AddStopToBus(const std::vector<std::string_view>& stops_from_request, std::string_view bus_name) {
@@ -17,12 +22,6 @@ namespace transport_catalogue {
 		}
 	}
 
-	void TransportCatalogue::AddBusToStop(const std::vector<std::string_view>& stops_from_request, std::string_view bus_name) {
-		for (auto stop : stops_from_request) {
-			stopname_to_stop_.at(stop)->buses.push_back(FindBus(bus_name));
-		}
-	}
-
 	domain::Stop* TransportCatalogue::FindStop(std::string_view stop_name) const {
 		if (stopname_to_stop_.empty() || stopname_to_stop_.count(stop_name) == 0) {
 			return nullptr;
@@ -39,12 +38,39 @@ namespace transport_catalogue {
 	}
 
 	void TransportCatalogue::SetDistance(std::vector<domain::Distance> distances_from_request) {
+		bool is_index_stale = false;
+		const bool has_bus_stats = !bus_stats_.empty();
 		for (auto dist : distances_from_request) {
+			if (are_distances_indexed_) {
+				// A known pair is patched in place, the reverse direction too unless it is set on its own
+				const size_t forward = FindIndexedDistance(dist.stop_from->id, dist.stop_to->id);
+				const size_t backward = FindIndexedDistance(dist.stop_to->id, dist.stop_from->id);
+				if (forward != indexed_distances_.size() && backward != indexed_distances_.size()) {
+					indexed_distances_[forward].distance = dist.distance;
+					indexed_distances_[forward].is_set = true;
+					if (!indexed_distances_[backward].is_set) {
+						indexed_distances_[backward].distance = dist.distance;
+					}
+					continue;
+				}
+				RestoreDistances();
+				is_index_stale = true;
+			}
 			distances_[std::make_pair(dist.stop_from, dist.stop_to)] = dist.distance;
 		}
+		if (is_index_stale) {
+			BuildDistanceIndex();
+		}
+		if (has_bus_stats) {
+			RefreshBusStats(distances_from_request);
+		}
 	}
 
 	int TransportCatalogue::GetDistance(const domain::Stop* stop_from, const domain::Stop* stop_to) const {
+		if (are_distances_indexed_) {
+			const size_t position = FindIndexedDistance(stop_from->id, stop_to->id);
+			return position == indexed_distances_.size() ? 0 : indexed_distances_[position].distance;
+		}
 		if (distances_.count({ stop_from, stop_to }) > 0) {
 			return distances_.at(std::make_pair(stop_from, stop_to));
 		}
@@ -54,8 +80,151 @@ namespace transport_catalogue {
 		return 0;
 	}
 
+	void TransportCatalogue::Finalize() {
+		if (!are_distances_indexed_) {
+			BuildDistanceIndex();
+		}
+		BuildStopBuses();
+		BuildBusStats();
+	}
+
+	BusStats TransportCatalogue::GetBusStats(const domain::Bus* bus) const {
+		if (bus->id >= bus_stats_.size()) {
+			return detail::CalculateBusStats(*this, bus); // added after Finalize
+		}
+		return bus_stats_[bus->id];
+	}
+
+	void TransportCatalogue::BuildBusStats() {
+		bus_stats_.assign(buses_.size(), BusStats{});
+		if (!thread_pool_) {
+			thread_pool_ = std::make_unique<thread_pool::ThreadPool>();
+		}
+		thread_pool_->ParallelFor(buses_.size(), [this](size_t bus_id) {
+			bus_stats_[bus_id] = detail::CalculateBusStats(*this, &buses_[bus_id]);
+		});
+	}
+
+	void TransportCatalogue::RefreshBusStats(const std::vector<domain::Distance>& distances) {
+		// A distance is used in both directions, the stop lists and the geographical lengths are not changed
+		std::vector<uint32_t> bus_ids;
+		for (const domain::Distance& dist : distances) {
+			for (const uint32_t bus_id : GetStopBusIds(dist.stop_from)) {
+				const auto& stops = buses_[bus_id].stops;
+				for (size_t i = 0; i + 1 < stops.size(); ++i) {
+					if ((stops[i] == dist.stop_from && stops[i + 1] == dist.stop_to)
+						|| (stops[i] == dist.stop_to && stops[i + 1] == dist.stop_from)) {
+						bus_ids.push_back(bus_id);
+						break;
+					}
+				}
+			}
+		}
+		std::sort(bus_ids.begin(), bus_ids.end());
+		bus_ids.erase(std::unique(bus_ids.begin(), bus_ids.end()), bus_ids.end());
+		for (const uint32_t bus_id : bus_ids) {
+			if (bus_id < bus_stats_.size()) {
+				BusStats& stats = bus_stats_[bus_id];
+				stats.route_length = detail::CalculateRouteRoadLength(*this, &buses_[bus_id]);
+				stats.curvature = detail::CalculateCurvature(stats.route_length, stats.geographical_length);
+			}
+		}
+	}
+
+	ArrayRange<uint32_t> TransportCatalogue::GetStopBusIds(const domain::Stop* stop) const {
+		if (stop->id + 1 >= stop_bus_offsets_.size()) {
+			return { nullptr, nullptr }; // added after Finalize
+		}
+		return { stop_bus_ids_.data() + stop_bus_offsets_[stop->id], stop_bus_ids_.data() + stop_bus_offsets_[stop->id + 1] };
+	}
+
+	const domain::Bus* TransportCatalogue::GetBus(uint32_t bus_id) const {
+		return &buses_.at(bus_id);
+	}
+
+	void TransportCatalogue::BuildDistanceIndex() {
+		std::vector<std::tuple<uint32_t, uint32_t, int, bool>> entries;
+		entries.reserve(distances_.size() * 2);
+		for (const auto& [stops, distance] : distances_) {
+			entries.emplace_back(stops.first->id, stops.second->id, distance, true);
+			if (distances_.count({ stops.second, stops.first }) == 0) {
+				entries.emplace_back(stops.second->id, stops.first->id, distance, false);
+			}
+		}
+		std::sort(entries.begin(), entries.end());
+
+		distance_offsets_.assign(stops_.size() + 1, 0);
+		indexed_distances_.clear();
+		indexed_distances_.reserve(entries.size());
+		for (const auto& [stop_from, stop_to, distance, is_set] : entries) {
+			++distance_offsets_[stop_from + 1];
+			indexed_distances_.push_back({ stop_to, distance, is_set });
+		}
+		for (size_t stop = 0; stop < stops_.size(); ++stop) {
+			distance_offsets_[stop + 1] += distance_offsets_[stop];
+		}
+		distances_ = {};
+		are_distances_indexed_ = true;
+	}
+
+	void TransportCatalogue::RestoreDistances() {
+		for (uint32_t stop_from = 0; stop_from + 1 < distance_offsets_.size(); ++stop_from) {
+			for (uint32_t i = distance_offsets_[stop_from]; i < distance_offsets_[stop_from + 1]; ++i) {
+				const IndexedDistance& entry = indexed_distances_[i];
+				if (entry.is_set) {
+					distances_[{ &stops_[stop_from], &stops_[entry.stop_id] }] = entry.distance;
+				}
+			}
+		}
+		distance_offsets_ = {};
+		indexed_distances_ = {};
+		are_distances_indexed_ = false;
+	}
+
+	void TransportCatalogue::BuildStopBuses() {
+		// Buses are taken in the order of the names and counted once per stop, a bus comes back to a stop
+		// before any other bus is taken
+		const uint32_t NO_BUS = std::numeric_limits<uint32_t>::max();
+		const auto sorted_buses = GetSortedBuses();
+		std::vector<uint32_t> last_buses(stops_.size(), NO_BUS);
+		stop_bus_offsets_.assign(stops_.size() + 1, 0);
+		for (const auto& [bus_name, bus_ptr] : sorted_buses) {
+			for (const domain::Stop* stop : bus_ptr->stops) {
+				if (last_buses[stop->id] != bus_ptr->id) {
+					last_buses[stop->id] = bus_ptr->id;
+					++stop_bus_offsets_[stop->id + 1];
+				}
+			}
+		}
+		for (size_t stop = 0; stop < stops_.size(); ++stop) {
+			stop_bus_offsets_[stop + 1] += stop_bus_offsets_[stop];
+		}
+
+		stop_bus_ids_.assign(stop_bus_offsets_.back(), 0);
+		std::vector<uint32_t> positions(stop_bus_offsets_.begin(), std::prev(stop_bus_offsets_.end()));
+		last_buses.assign(stops_.size(), NO_BUS);
+		for (const auto& [bus_name, bus_ptr] : sorted_buses) {
+			for (const domain::Stop* stop : bus_ptr->stops) {
+				if (last_buses[stop->id] != bus_ptr->id) {
+					last_buses[stop->id] = bus_ptr->id;
+					stop_bus_ids_[positions[stop->id]++] = bus_ptr->id;
+				}
+			}
+		}
+	}
+
+	size_t TransportCatalogue::FindIndexedDistance(uint32_t stop_from, uint32_t stop_to) const {
+		const auto begin = indexed_distances_.begin() + distance_offsets_[stop_from];
+		const auto end = indexed_distances_.begin() + distance_offsets_[stop_from + 1];
+		const auto it = std::lower_bound(begin, end, stop_to, [](const IndexedDistance& entry, uint32_t stop) {
+			return entry.stop_id < stop;
+		});
+		return it != end && it->stop_id == stop_to ? static_cast<size_t>(it - indexed_distances_.begin()) : indexed_distances_.size();
+	}
+
 	void TransportCatalogue::AddBus(std::string_view bus_name, domain::BusType bus_type_from_request) {
 		domain::Bus bus;
+		bus.id = static_cast<uint32_t>(buses_.size());
 		bus.name = bus_name;
 		if (bus_type_from_request == domain::BusType::CIRCULAR) {
 			bus.bus_type = domain::BusType::CIRCULAR;
@@ -84,14 +253,11 @@ namespace transport_catalogue {
 
 	namespace detail {
 
-		std::vector<std::string> GetSortedUniqueBuses(const domain::Stop* stop) {
-			std::unordered_set<domain::Bus*> unique_buses_from_stop;
-			unique_buses_from_stop.insert(stop->buses.begin(), stop->buses.end());
+		std::vector<std::string> GetSortedUniqueBuses(const TransportCatalogue& catalogue, const domain::Stop* stop) {
 			std::vector<std::string> sorted_unique_buses;
-			for (auto bus : unique_buses_from_stop) {
-				sorted_unique_buses.push_back(bus->name);
+			for (const uint32_t bus_id : catalogue.GetStopBusIds(stop)) {
+				sorted_unique_buses.push_back(catalogue.GetBus(bus_id)->name);
 			}
-			std::sort(sorted_unique_buses.begin(), sorted_unique_buses.end());
 			return sorted_unique_buses;
 		}
 
@@ -100,9 +266,13 @@ namespace transport_catalogue {
 		}
 
 		int CalculateUniqueStops(const domain::Bus* bus) {
-			std::unordered_set<domain::Stop*> unique_stops_set;
-			unique_stops_set.insert(bus->stops.begin(), bus->stops.end());
-			return static_cast<int>(unique_stops_set.size());
+			std::vector<uint32_t> stop_ids;
+			stop_ids.reserve(bus->stops.size());
+			for (const domain::Stop* stop : bus->stops) {
+				stop_ids.push_back(stop->id);
+			}
+			std::sort(stop_ids.begin(), stop_ids.end());
+			return static_cast<int>(std::unique(stop_ids.begin(), stop_ids.end()) - stop_ids.begin());
 		}
 
 		double CalculateRouteGeographicalLength(const domain::Bus* bus) {
@@ -116,7 +286,7 @@ namespace transport_catalogue {
 
 		int CalculateRouteRoadLength(const TransportCatalogue& catalogue, const domain::Bus* bus) {
 			int road_length = 0;
-			for (uint64_t i = 0; i < bus->stops.size() - 1; ++i) {
+			for (uint64_t i = 0; i + 1 < bus->stops.size(); ++i) {
 				road_length += catalogue.GetDistance(bus->stops[i], bus->stops[i + 1]);
 			}
 			return road_length;
@@ -126,6 +296,20 @@ namespace transport_catalogue {
 			return static_cast<double>(CalculateRouteRoadLength(catalogue, bus) / CalculateRouteGeographicalLength(bus));
 		}
 
+		double CalculateCurvature(int route_length, double geographical_length) {
+			return geographical_length > 0.0 ? route_length / geographical_length : 0.0;
+		}
+
+		BusStats CalculateBusStats(const TransportCatalogue& catalogue, const domain::Bus* bus) {
+			BusStats stats;
+			stats.stop_count = CalculateStops(bus);
+			stats.unique_stop_count = CalculateUniqueStops(bus);
+			stats.route_length = CalculateRouteRoadLength(catalogue, bus);
+			stats.geographical_length = CalculateRouteGeographicalLength(bus);
+			stats.curvature = CalculateCurvature(stats.route_length, stats.geographical_length);
+			return stats;
+		}
+
 	}
 
 } // namespace transport_catalogue
\ No newline at end of file
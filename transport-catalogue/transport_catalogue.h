@@ -2,14 +2,19 @@
 
 #include "domain.h"
 #include "geo.h"
+#include "thread_pool.h"
 
 #include <algorithm>
+#include <cstdint>
 #include <deque>
+#include <limits>
 #include <map>
+#include <memory>
 #include <stdexcept>
 #include <string>
+#include <tuple>
 #include <unordered_map>
-#include <unordered_set>
+#include <utility>
 #include <vector>
 
 namespace transport_catalogue {
@@ -21,17 +26,64 @@ namespace transport_catalogue {
 		}
 	};
 
+	// Read-only view of a part of one of the flat arrays of the catalogue
+	template <typename T>
+	class ArrayRange {
+	public:
+		ArrayRange(const T* begin, const T* end)
+			: begin_(begin)
+			, end_(end) {
+		}
+
+		const T* begin() const {
+			return begin_;
+		}
+		const T* end() const {
+			return end_;
+		}
+		size_t size() const {
+			return static_cast<size_t>(end_ - begin_);
+		}
+		bool empty() const {
+			return begin_ == end_;
+		}
+
+	private:
+		const T* begin_;
+		const T* end_;
+	};
+
+	struct BusStats {
+		int stop_count = 0;
+		int unique_stop_count = 0;
+		int route_length = 0;
+		double geographical_length = 0.0;
+		double curvature = 0.0;
+	};
+
 	class TransportCatalogue {
 	public:
 		void AddStop(std::string_view stop_name, geo::Coordinates coordinates);
 		void AddStopToBus(const std::vector<std::string_view>& stops_from_request, std::string_view bus_name);
-		void AddBusToStop(const std::vector<std::string_view>& stops_from_request, std::string_view bus_name);
 		domain::Stop* FindStop(std::string_view stop_name) const;
 		std::map<std::string_view, domain::Stop*> GetSortedStops() const;
 
 		void SetDistance(std::vector<domain::Distance> distances_from_request);
 		int GetDistance(const domain::Stop* stop_from, const domain::Stop* stop_to) const;
 
+		// Freezes the catalogue for reading: the distances go into a flat index by the stop ids, with the reverse direction
+		// resolved in advance, the buses of every stop into a flat array and the stats of every bus are computed.
+		// Distances set afterwards are written to the index and the stats too, new stops and buses and changed routes
+		// are seen after the next Finalize.
+		void Finalize();
+
+		// Computed by Finalize for the buses known then, on the fly for the others
+		BusStats GetBusStats(const domain::Bus* bus) const;
+
+		// Buses through the stop, each once, in the order of the names
+		ArrayRange<uint32_t> GetStopBusIds(const domain::Stop* stop) const;
+		const domain::Bus* GetBus(uint32_t bus_id) const;
+
 		void AddBus(std::string_view bus_name, domain::BusType bus_type);
 		domain::Bus* FindBus(std::string_view bus_name) const;
 		std::map<std::string_view, domain::Bus*> GetSortedBuses() const;
@@ -40,20 +92,54 @@ namespace transport_catalogue {
 		std::deque<domain::Stop> stops_;
 		std::unordered_map<std::string_view, domain::Stop*> stopname_to_stop_;
 
+		// Distances are kept in the hash map until Finalize and only in the index afterwards
 		std::unordered_map<std::pair<const domain::Stop*, const domain::Stop*>, int, DistanceHasher> distances_;
 
+		struct IndexedDistance {
+			uint32_t stop_id = 0;
+			int distance = 0;
+			bool is_set = false; // false if the distance is the one set for the reverse direction
+		};
+
+		// Distances from every stop, sorted by the stop id; valid while are_distances_indexed_
+		bool are_distances_indexed_ = false;
+		std::vector<uint32_t> distance_offsets_;
+		std::vector<IndexedDistance> indexed_distances_;
+
+		// Buses of every stop by the stop id
+		std::vector<uint32_t> stop_bus_offsets_;
+		std::vector<uint32_t> stop_bus_ids_;
+
+		// By the bus id
+		std::vector<BusStats> bus_stats_;
+		// Workers of the bus stats, started by the first Finalize and kept for the next ones
+		std::unique_ptr<thread_pool::ThreadPool> thread_pool_;
+
+		void BuildDistanceIndex();
+		// Moves the distances from the index back to the hash map
+		void RestoreDistances();
+		void BuildStopBuses();
+		void BuildBusStats();
+		// Recomputes the lengths of the buses passing between the stops
+		void RefreshBusStats(const std::vector<domain::Distance>& distances);
+		// Position in indexed_distances_, or its size if the stops have no distance
+		size_t FindIndexedDistance(uint32_t stop_from, uint32_t stop_to) const;
+
 		std::deque<domain::Bus> buses_;
 		std::unordered_map<std::string_view, domain::Bus*> busname_to_bus_;
 	};
 
 	namespace detail {
 
-		std::vector<std::string> GetSortedUniqueBuses(const domain::Stop* stop);
+		std::vector<std::string> GetSortedUniqueBuses(const TransportCatalogue& catalogue, const domain::Stop* stop);
 		int CalculateStops(const domain::Bus* bus);
 		int CalculateUniqueStops(const domain::Bus* bus);
 		double CalculateRouteGeographicalLength(const domain::Bus* bus);
 		int CalculateRouteRoadLength(const TransportCatalogue& catalogue, const domain::Bus* bus);
 		double CalculateRouteCurvature(const TransportCatalogue& catalogue, const domain::Bus* bus);
+		// 0 for a route without geographical length, e.g. a bus without stops
+		double CalculateCurvature(int route_length, double geographical_length);
+		BusStats CalculateBusStats(const TransportCatalogue& catalogue, const domain::Bus* bus);
 
 	} // namespace detail
 
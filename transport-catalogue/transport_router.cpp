@@ -1,13 +1,116 @@
 #include "transport_router.h"
 
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
 namespace transport_router {
 
-    void TransportRouter::FillGraphByStops() {
-        const auto& stops = catalogue_.GetSortedStops();
-        graph_ = graph::DirectedWeightedGraph<double>(stops.size() * 2);
+    namespace {
+
+        const double BYTES_PER_MB = 1024.0 * 1024.0;
+
+        // Spelled out instead of M_PI, which is not standard and needs _USE_MATH_DEFINES on MSVC
+        const double DEGREES_TO_RADIANS = 3.14159265358979323846 / 180.0;
+
+        // Buses whose edges are generated in parallel before they are added to the graph
+        const size_t BUS_BATCH_SIZE = 64;
+
+        // RouterType::PARTITION: a cell of a level is made of 2^LEVEL_SPLIT_COUNT cells of the level below,
+        // and a level is added while it has at least that many cells
+        const int LEVEL_SPLIT_COUNT = 3;
+
+        // Side of the grid the coordinates are rounded to for the Hilbert curve, 2^HILBERT_ORDER cells
+        const int HILBERT_ORDER = 16;
+
+        // Position of the cell (x, y) along the Hilbert curve filling the grid.
+        // Cells close on the curve are close on the map, so is the memory of the stops numbered along it.
+        uint64_t ComputeHilbertIndex(uint32_t x, uint32_t y) {
+            const uint32_t side = 1u << HILBERT_ORDER;
+            uint64_t index = 0;
+            for (uint32_t half = side / 2; half > 0; half /= 2) {
+                const uint32_t rx = (x & half) > 0 ? 1 : 0;
+                const uint32_t ry = (y & half) > 0 ? 1 : 0;
+                index += static_cast<uint64_t>(half) * half * ((3 * rx) ^ ry);
+                // The quadrant is turned so that the curve in it runs the way the next smaller curve does
+                if (ry == 0) {
+                    if (rx == 1) {
+                        x = side - 1 - x;
+                        y = side - 1 - y;
+                    }
+                    std::swap(x, y);
+                }
+            }
+            return index;
+        }
+
+        using IndexedCoordinates = std::pair<geo::Coordinates, size_t>;
+
+        // Splits the stops at the median of the longer side of their bounding box depth times.
+        // The cell of a stop is the sequence of the halves it has fallen into, as binary digits.
+        void BisectStops(std::vector<IndexedCoordinates>::iterator begin, std::vector<IndexedCoordinates>::iterator end,
+            int depth, uint32_t cell, std::vector<uint32_t>& stop_cells) {
+            if (depth == 0) {
+                for (auto it = begin; it != end; ++it) {
+                    stop_cells[it->second] = cell;
+                }
+                return;
+            }
+            const auto middle = begin + (end - begin) / 2;
+            if (begin != end) {
+                auto [min_lat, max_lat] = std::minmax_element(begin, end, [](const auto& lhs, const auto& rhs) {
+                    return lhs.first.lat < rhs.first.lat;
+                });
+                auto [min_lng, max_lng] = std::minmax_element(begin, end, [](const auto& lhs, const auto& rhs) {
+                    return lhs.first.lng < rhs.first.lng;
+                });
+                // A degree of longitude shrinks with the cosine of the latitude
+                const double lat_extent = max_lat->first.lat - min_lat->first.lat;
+                const double lng_extent = (max_lng->first.lng - min_lng->first.lng)
+                    * std::cos((max_lat->first.lat + min_lat->first.lat) / 2.0 * DEGREES_TO_RADIANS);
+                if (lat_extent >= lng_extent) {
+                    std::nth_element(begin, middle, end, [](const auto& lhs, const auto& rhs) {
+                        return lhs.first.lat < rhs.first.lat;
+                    });
+                }
+                else {
+                    std::nth_element(begin, middle, end, [](const auto& lhs, const auto& rhs) {
+                        return lhs.first.lng < rhs.first.lng;
+                    });
+                }
+            }
+            BisectStops(begin, middle, depth - 1, cell * 2, stop_cells);
+            BisectStops(middle, end, depth - 1, cell * 2 + 1, stop_cells);
+        }
+
+    } // namespace
+
+    void TransportRouter::FillGraphByStops(const std::vector<const domain::Stop*>& stops) {
+        if (routing_settings_.graph_model == GraphModel::COLLAPSED) {
+            graph_ = graph::DirectedWeightedGraph<double>(stops.size());
+            vertex_stops_ = stops;
+            for (size_t i = 0; i < stops.size(); ++i) {
+                stops_id_[stops[i]->name] = i;
+            }
+            return;
+        }
+        first_riding_vertex_ = stops.size() * 2;
+        vertex_stops_.assign(first_riding_vertex_, nullptr);
+        size_t vertex_count = first_riding_vertex_;
+        if (routing_settings_.graph_model == GraphModel::RIDING) {
+            riding_buses_ = OrderBuses(stops);
+            for (const domain::Bus* bus_ptr : riding_buses_) {
+                vertex_count += bus_ptr->stops.size();
+            }
+        }
+        graph_ = graph::DirectedWeightedGraph<double>(vertex_count);
         graph::VertexId vertex_id = 0;
-        for (const auto& [stop_name, stop_ptr] : stops) {
+        for (const domain::Stop* stop_ptr : stops) {
             stops_id_[stop_ptr->name] = vertex_id;
+            vertex_stops_[vertex_id] = stop_ptr;
+            stop_wait_edges_[stop_ptr] = graph_.GetEdgeCount();
             graph_.AddEdge({ vertex_id,
                 ++vertex_id,
                 static_cast<double>(routing_settings_.bus_wait_time),
@@ -20,38 +123,861 @@ namespace transport_router {
 
     void TransportRouter::FillGraphByBuses() {
         const double сoeff = 1000.0 / 60.0; // multiplication coefficient for converting the division result in minutes
-        const auto& buses = catalogue_.GetSortedBuses();
-        for (auto& [bus_name, bus_ptr] : buses) {
-            size_t stops_count = bus_ptr->stops.size();
-            for (int i = 0; i < stops_count; ++i) {
-                double distance = 0.0;
-                for (int j = i + 1; j < stops_count; ++j) {
-                    const domain::Stop* stop_from = bus_ptr->stops[i];
-                    const domain::Stop* stop_to = bus_ptr->stops[j];
-                    distance += catalogue_.GetDistance(bus_ptr->stops[j - 1], stop_to);
-                    graph_.AddEdge({ stops_id_.at(stop_from->name) + 1,
-                        stops_id_.at(stop_to->name),
-                        static_cast<double>(distance) / (routing_settings_.bus_velocity * сoeff),
-                        bus_ptr->name,
-                        j - i,
+        std::vector<const domain::Bus*> buses;
+        for (const auto& [bus_name, bus_ptr] : catalogue_.GetSortedBuses()) {
+            buses.push_back(bus_ptr);
+        }
+        // Without the wait vertices the bus leaves right from the stop vertex and the edge includes the wait
+        const bool is_collapsed = routing_settings_.graph_model == GraphModel::COLLAPSED;
+        const graph::VertexId departure_shift = is_collapsed ? 0 : 1;
+        const double boarding_time = is_collapsed ? static_cast<double>(routing_settings_.bus_wait_time) : 0.0;
+
+        size_t edge_count = graph_.GetEdgeCount();
+        for (const domain::Bus* bus : buses) {
+            edge_count += bus->stops.size() * (bus->stops.size() - !bus->stops.empty()) / 2;
+        }
+        graph_.ReserveEdges(edge_count);
+        ride_times_.clear();
+
+        // The edges of every bus are generated independently, a batch of buses at a time, then added in the order
+        // of the buses, so the edge ids are the same whatever the number of threads
+        std::vector<std::vector<graph::Edge<double>>> bus_edges(std::min(BUS_BATCH_SIZE, buses.size()));
+        std::vector<std::vector<double>> bus_ride_times(bus_edges.size());
+        for (size_t batch_begin = 0; batch_begin < buses.size(); batch_begin += BUS_BATCH_SIZE) {
+            const size_t batch_size = std::min(BUS_BATCH_SIZE, buses.size() - batch_begin);
+            thread_pool_->ParallelFor(batch_size, [&](size_t index) {
+                const domain::Bus* bus = buses[batch_begin + index];
+                const size_t stops_count = bus->stops.size();
+                // Distance from the first stop, a sum of integers, so the differences are exact
+                std::vector<double> distances(stops_count, 0.0);
+                std::vector<graph::VertexId> vertices(stops_count);
+                for (size_t i = 0; i < stops_count; ++i) {
+                    vertices[i] = stops_id_.at(bus->stops[i]->name);
+                    if (i > 0) {
+                        distances[i] = distances[i - 1] + catalogue_.GetDistance(bus->stops[i - 1], bus->stops[i]);
+                    }
+                }
+
+                auto& edges = bus_edges[index];
+                edges.clear();
+                bus_ride_times[index].clear();
+                for (size_t i = 0; i < stops_count; ++i) {
+                    for (size_t j = i + 1; j < stops_count; ++j) {
+                        const double ride_time = (distances[j] - distances[i]) / (routing_settings_.bus_velocity * сoeff);
+                        edges.push_back({ vertices[i] + departure_shift,
+                            vertices[j],
+                            boarding_time + ride_time,
+                            bus->name,
+                            static_cast<int>(j - i),
+                            graph::ItemsType::BUS });
+                        if (is_collapsed) {
+                            bus_ride_times[index].push_back(ride_time);
+                        }
+                    }
+                }
+            });
+
+            for (size_t index = 0; index < batch_size; ++index) {
+                bus_first_edges_[buses[batch_begin + index]] = graph_.GetEdgeCount();
+                for (const auto& edge : bus_edges[index]) {
+                    graph_.AddEdge(edge);
+                }
+                ride_times_.insert(ride_times_.end(), bus_ride_times[index].begin(), bus_ride_times[index].end());
+            }
+        }
+    }
+
+    void TransportRouter::FillGraphByRides() {
+        // Boarding and alighting are free, the wait is on the edge of the stop.
+        // A ride keeps the bus vertices consecutive, so its span_count is the difference of the vertex ids.
+        graph::VertexId riding_vertex = first_riding_vertex_;
+        riding_distances_.clear();
+        riding_distances_.reserve(graph_.GetVertexCount() - first_riding_vertex_);
+        for (const domain::Bus* bus_ptr : riding_buses_) {
+            bus_first_edges_[bus_ptr] = graph_.GetEdgeCount();
+            const size_t stops_count = bus_ptr->stops.size();
+            double distance = 0.0;
+            for (size_t i = 0; i < stops_count; ++i, ++riding_vertex) {
+                const graph::VertexId stop_vertex = stops_id_.at(bus_ptr->stops[i]->name);
+                if (i > 0) {
+                    distance += catalogue_.GetDistance(bus_ptr->stops[i - 1], bus_ptr->stops[i]);
+                }
+                riding_distances_.push_back(distance);
+                graph_.AddEdge({ stop_vertex + 1, riding_vertex, 0.0, bus_ptr->name, 0, graph::ItemsType::DEFAULT });
+                graph_.AddEdge({ riding_vertex, stop_vertex, 0.0, bus_ptr->name, 0, graph::ItemsType::DEFAULT });
+                if (i + 1 < stops_count) {
+                    const int hop_distance = catalogue_.GetDistance(bus_ptr->stops[i], bus_ptr->stops[i + 1]);
+                    graph_.AddEdge({ riding_vertex, riding_vertex + 1, ComputeRideTime(hop_distance), bus_ptr->name, 1,
                         graph::ItemsType::BUS });
                 }
             }
         }
     }
 
+    void TransportRouter::FillGraphByWalks(const std::vector<const domain::Stop*>& stops) {
+        // A walk leads from the arrival at a stop to the arrival at another one, so it may follow a ride or another walk
+        // and the wait for the next bus is paid at the stop it ends at
+        for (const raptor_router::Transfer& transfer : FindWalkingTransfers(stops)) {
+            const graph::EdgeId edge_id = graph_.AddEdge({ stops_id_.at(transfer.from->name),
+                stops_id_.at(transfer.to->name),
+                transfer.walk_time,
+                transfer.from->name,
+                0,
+                graph::ItemsType::WALK });
+            if (routing_settings_.graph_model == GraphModel::COLLAPSED) {
+                ride_times_.push_back(transfer.walk_time);
+            }
+            stop_walk_edges_[transfer.from].push_back(edge_id);
+            stop_walk_edges_[transfer.to].push_back(edge_id);
+        }
+    }
+
+    std::vector<raptor_router::Transfer> TransportRouter::FindWalkingTransfers(const std::vector<const domain::Stop*>& stops) const {
+        std::vector<raptor_router::Transfer> transfers;
+        if (!(routing_settings_.walk_radius > 0.0)) {
+            return transfers;
+        }
+        std::vector<geo::Coordinates> points;
+        points.reserve(stops.size());
+        for (const domain::Stop* stop : stops) {
+            points.push_back(stop->coordinates);
+        }
+        for (const geo::PointPair& pair : geo::FindClosePairs(points, routing_settings_.walk_radius)) {
+            const domain::Stop* first = stops[pair.first];
+            const domain::Stop* second = stops[pair.second];
+            transfers.push_back({ first, second, ComputeWalkTime(first, second) });
+            transfers.push_back({ second, first, ComputeWalkTime(second, first) });
+        }
+        return transfers;
+    }
+
+    double TransportRouter::ComputeRideTime(double distance) const {
+        const double coeff = 1000.0 / 60.0;
+        return distance / (routing_settings_.bus_velocity * coeff);
+    }
+
+    double TransportRouter::ComputeWalkTime(const domain::Stop* from, const domain::Stop* to) const {
+        const double coeff = 1000.0 / 60.0;
+        const double distance = geo::ComputeDistance(from->coordinates, to->coordinates);
+        return std::isnan(distance) ? 0.0 : distance / (routing_settings_.walk_velocity * coeff);
+    }
+
     void TransportRouter::CreateGraph() {
-        FillGraphByStops();
-        FillGraphByBuses();
-        router_ = std::make_unique<graph::Router<double>>(graph_);
+        const std::vector<const domain::Stop*> stops = OrderStops();
+        if (routing_settings_.router_type == RouterType::RAPTOR) {
+            raptor_router_ = std::make_unique<raptor_router::RaptorRouter>(catalogue_, routing_settings_.bus_wait_time,
+                routing_settings_.bus_velocity, stops, OrderBuses(stops), FindWalkingTransfers(stops));
+            return;
+        }
+        router_.reset();
+        stops_id_.clear();
+        stop_wait_edges_.clear();
+        bus_first_edges_.clear();
+        stop_walk_edges_.clear();
+        frozen_graph_ = graph::CsrGraph<double>();
+        FillGraphByStops(stops);
+        if (routing_settings_.graph_model == GraphModel::RIDING) {
+            FillGraphByRides();
+        }
+        else {
+            FillGraphByBuses();
+        }
+        FillGraphByWalks(stops);
+        if (routing_settings_.prune_parallel_edges) {
+            PruneParallelEdges();
+        }
+        if (routing_settings_.router_type == RouterType::AUTO) {
+            ChooseRouterType();
+        }
+        if (routing_settings_.router_type == RouterType::DIJKSTRA || routing_settings_.router_type == RouterType::ALT
+            || routing_settings_.router_type == RouterType::PARTITION) {
+            frozen_graph_ = graph::CsrGraph<double>(graph_);
+        }
+        if (!router_) {
+            CreateRouter();
+        }
+    }
+
+    void TransportRouter::PruneParallelEdges() {
+        // Closures are weighted in while the edges are where the refresh expects them
+        EdgeWeights old_weights;
+        for (const domain::Stop* stop : disabled_stops_) {
+            RefreshStopEdges(stop, old_weights);
+            for (const uint32_t bus_id : catalogue_.GetStopBusIds(stop)) {
+                RefreshBusEdges(catalogue_.GetBus(bus_id), old_weights);
+            }
+        }
+        for (const domain::Bus* bus : disabled_buses_) {
+            RefreshBusEdges(bus, old_weights);
+        }
+
+        const std::vector<graph::EdgeId> kept_edges = graph::FindLightestParallelEdges(graph_);
+        graph::DirectedWeightedGraph<double> pruned_graph(graph_.GetVertexCount());
+        std::vector<double> ride_times;
+        for (const graph::EdgeId edge_id : kept_edges) {
+            pruned_graph.AddEdge(graph_.GetEdge(edge_id));
+            if (!ride_times_.empty()) {
+                ride_times.push_back(ride_times_[edge_id]);
+            }
+        }
+        pruned_edge_count_ = graph_.GetEdgeCount() - pruned_graph.GetEdgeCount();
+        graph_ = std::move(pruned_graph);
+        ride_times_ = std::move(ride_times);
+        // The edges of a stop or a bus are not where they were, changes rebuild the graph
+        stop_wait_edges_.clear();
+        bus_first_edges_.clear();
+        stop_walk_edges_.clear();
+    }
+
+    void TransportRouter::CreateRouter() {
+        if (routing_settings_.router_type == RouterType::DIJKSTRA) {
+            router_ = std::make_unique<graph::DijkstraRouter<double>>(frozen_graph_);
+        }
+        else if (routing_settings_.router_type == RouterType::CONTRACTION_HIERARCHY) {
+            router_ = std::make_unique<graph::ContractionHierarchyRouter<double>>(graph_);
+        }
+        else if (routing_settings_.router_type == RouterType::ALT) {
+            router_ = std::make_unique<graph::AltRouter<double>>(frozen_graph_, SelectLandmarks(), *thread_pool_);
+        }
+        else if (routing_settings_.router_type == RouterType::PARTITION) {
+            router_ = std::make_unique<graph::PartitionRouter<double>>(frozen_graph_, PartitionVertices(), *thread_pool_);
+        }
+        else {
+            const uint64_t cache_key = ComputeCacheKey();
+            if (routing_settings_.use_fixed_point_tables) {
+                CreateFixedPointRouter(cache_key, LoadCachedTable<uint32_t>(cache_key));
+            }
+            else if (routing_settings_.use_compact_tables) {
+                CreateAllPairsRouter<float>(cache_key, LoadCachedTable<float>(cache_key));
+            }
+            else {
+                CreateAllPairsRouter<double>(cache_key, LoadCachedTable<double>(cache_key));
+            }
+        }
+    }
+
+    void TransportRouter::ChooseRouterType() {
+        const double vertex_count = static_cast<double>(graph_.GetVertexCount());
+        const double thread_count = static_cast<double>(thread_pool_->GetThreadCount());
+        const double table_size = vertex_count * vertex_count;
+        const double full_bytes = table_size * (sizeof(double) + sizeof(uint32_t));
+        const double compact_bytes = table_size * (sizeof(float) + sizeof(uint32_t));
+        const double full_seconds = table_size * vertex_count * routing_settings_.all_pairs_seconds_per_step / thread_count;
+        const double compact_seconds = full_seconds / 2.0;
+        // Distances from and to every landmark and the reversed arcs
+        const double landmark_bytes = 2.0 * routing_settings_.landmark_count * vertex_count * sizeof(double)
+            + graph_.GetEdgeCount() * (sizeof(uint32_t) + sizeof(double)) + vertex_count * sizeof(size_t);
+        const double memory_budget = static_cast<double>(routing_settings_.memory_budget);
+        const double time_budget = routing_settings_.precompute_time_budget;
+
+        // The key is hashed once and every table type is looked up only by the branch which can use it
+        const uint64_t cache_key = ComputeCacheKey();
+        std::ostringstream strategy;
+        strategy << std::setprecision(3);
+        // Fixed-point tables, if asked for, take the place of the float ones
+        const bool is_fixed_point = routing_settings_.use_fixed_point_tables;
+        if (!routing_settings_.use_compact_tables && !is_fixed_point && full_bytes <= memory_budget) {
+            if (auto cached_table = LoadCachedTable<double>(cache_key); cached_table || full_seconds <= time_budget) {
+                routing_settings_.router_type = RouterType::ALL_PAIRS;
+                strategy << "full all-pairs precompute, " << full_bytes / BYTES_PER_MB << " MB, about " << full_seconds << " s";
+                CreateAllPairsRouter<double>(cache_key, std::move(cached_table));
+            }
+        }
+        if (routing_settings_.router_type == RouterType::AUTO && compact_bytes <= memory_budget) {
+            if (is_fixed_point) {
+                if (auto cached_table = LoadCachedTable<uint32_t>(cache_key); cached_table || compact_seconds <= time_budget) {
+                    routing_settings_.router_type = RouterType::ALL_PAIRS;
+                    routing_settings_.use_compact_tables = true;
+                    CreateFixedPointRouter(cache_key, std::move(cached_table));
+                }
+            }
+            else if (auto cached_table = LoadCachedTable<float>(cache_key); cached_table || compact_seconds <= time_budget) {
+                routing_settings_.router_type = RouterType::ALL_PAIRS;
+                routing_settings_.use_compact_tables = true;
+                CreateAllPairsRouter<float>(cache_key, std::move(cached_table));
+            }
+            if (routing_settings_.router_type == RouterType::ALL_PAIRS) {
+                strategy << "all-pairs precompute with " << (is_fixed_point ? "fixed-point" : "float") << " tables, "
+                    << compact_bytes / BYTES_PER_MB << " MB, about " << compact_seconds << " s";
+            }
+        }
+        if (routing_settings_.router_type == RouterType::AUTO && routing_settings_.landmark_count > 0
+            && landmark_bytes <= memory_budget) {
+            routing_settings_.router_type = RouterType::ALT;
+            strategy << "on-demand A* search with " << routing_settings_.landmark_count << " landmarks, "
+                << landmark_bytes / BYTES_PER_MB << " MB";
+        }
+        else if (routing_settings_.router_type == RouterType::AUTO) {
+            routing_settings_.router_type = RouterType::DIJKSTRA;
+            strategy << "on-demand Dijkstra search, nothing precomputed";
+        }
+        if (routing_settings_.log_router_choice) {
+            std::cerr << "Routing strategy for " << graph_.GetVertexCount() << " vertices: " << strategy.str() << std::endl;
+        }
+    }
+
+    template <typename TableWeight>
+    TransportRouter::CachedTable<TableWeight> TransportRouter::LoadCachedTable(uint64_t cache_key) const {
+        if (routing_settings_.cache_path.empty()) {
+            return std::nullopt;
+        }
+        return routing_cache::LoadRouterTable<TableWeight>(routing_settings_.cache_path, cache_key, graph_);
+    }
+
+    template <typename TableWeight>
+    void TransportRouter::CreateAllPairsRouter(uint64_t cache_key, CachedTable<TableWeight> cached_table) {
+        if (cached_table) {
+            router_ = std::make_unique<graph::Router<double, TableWeight>>(graph_, std::move(*cached_table), *thread_pool_);
+            return;
+        }
+        auto router = std::make_unique<graph::Router<double, TableWeight>>(graph_, *thread_pool_);
+        if (is_initial_build_ && !routing_settings_.cache_path.empty()) {
+            // A failed save only costs the precompute on the next start
+            routing_cache::SaveRouterTable(routing_settings_.cache_path, cache_key, graph_, *router);
+        }
+        router_ = std::move(router);
+    }
+
+    void TransportRouter::CreateFixedPointRouter(uint64_t cache_key, CachedTable<uint32_t> cached_table) {
+        try {
+            CreateAllPairsRouter<uint32_t>(cache_key, std::move(cached_table));
+        }
+        catch (const std::overflow_error&) {
+            // The network has routes beyond the range of the fixed-point weights, the float tables take the same memory
+            routing_settings_.use_fixed_point_tables = false;
+            routing_settings_.use_compact_tables = true;
+            const uint64_t float_cache_key = ComputeCacheKey();
+            CreateAllPairsRouter<float>(float_cache_key, LoadCachedTable<float>(float_cache_key));
+        }
+    }
+
+    std::vector<graph::VertexId> TransportRouter::SelectLandmarks() const {
+        // Stops without buses are unreachable and give no bounds
+        std::vector<const domain::Stop*> stops;
+        for (const auto& [stop_name, stop_ptr] : catalogue_.GetSortedStops()) {
+            if (!catalogue_.GetStopBusIds(stop_ptr).empty()) {
+                stops.push_back(stop_ptr);
+            }
+        }
+        const size_t landmark_count = std::min(routing_settings_.landmark_count, stops.size());
+        std::vector<graph::VertexId> landmarks;
+        if (landmark_count == 0) {
+            return landmarks;
+        }
+
+        geo::Coordinates center;
+        for (const domain::Stop* stop : stops) {
+            center.lat += stop->coordinates.lat / stops.size();
+            center.lng += stop->coordinates.lng / stops.size();
+        }
+        auto compute_distance = [](geo::Coordinates from, geo::Coordinates to) {
+            // acos in ComputeDistance may return NaN for coinciding points
+            const double distance = geo::ComputeDistance(from, to);
+            return std::isnan(distance) ? 0.0 : distance;
+        };
+
+        // The first landmark is the stop farthest from the center, every next one is the farthest from the chosen ones
+        std::vector<double> distances_to_landmarks(stops.size());
+        for (size_t i = 0; i < stops.size(); ++i) {
+            distances_to_landmarks[i] = compute_distance(center, stops[i]->coordinates);
+        }
+        for (size_t landmark = 0; landmark < landmark_count; ++landmark) {
+            const size_t farthest = std::max_element(distances_to_landmarks.begin(), distances_to_landmarks.end())
+                - distances_to_landmarks.begin();
+            landmarks.push_back(stops_id_.at(stops[farthest]->name));
+            for (size_t i = 0; i < stops.size(); ++i) {
+                const double distance = compute_distance(stops[farthest]->coordinates, stops[i]->coordinates);
+                distances_to_landmarks[i] = landmark == 0 ? distance : std::min(distances_to_landmarks[i], distance);
+            }
+        }
+        return landmarks;
+    }
+
+    std::vector<const domain::Stop*> TransportRouter::OrderStops() const {
+        std::vector<const domain::Stop*> stops;
+        for (const auto& [stop_name, stop_ptr] : catalogue_.GetSortedStops()) {
+            stops.push_back(stop_ptr);
+        }
+        if (!routing_settings_.use_hilbert_order || stops.empty()) {
+            return stops;
+        }
+
+        // The bounding box of the stops is stretched over the grid, the names break the ties
+        auto [min_lat, max_lat] = std::minmax_element(stops.begin(), stops.end(), [](const domain::Stop* lhs, const domain::Stop* rhs) {
+            return lhs->coordinates.lat < rhs->coordinates.lat;
+        });
+        auto [min_lng, max_lng] = std::minmax_element(stops.begin(), stops.end(), [](const domain::Stop* lhs, const domain::Stop* rhs) {
+            return lhs->coordinates.lng < rhs->coordinates.lng;
+        });
+        auto to_grid = [](double value, double min, double max) {
+            const double last_cell = static_cast<double>((1u << HILBERT_ORDER) - 1);
+            return max > min ? static_cast<uint32_t>((value - min) / (max - min) * last_cell) : 0u;
+        };
+        std::vector<std::pair<uint64_t, size_t>> indices;
+        indices.reserve(stops.size());
+        for (size_t i = 0; i < stops.size(); ++i) {
+            const geo::Coordinates& coordinates = stops[i]->coordinates;
+            indices.push_back({ ComputeHilbertIndex(to_grid(coordinates.lng, (*min_lng)->coordinates.lng, (*max_lng)->coordinates.lng),
+                to_grid(coordinates.lat, (*min_lat)->coordinates.lat, (*max_lat)->coordinates.lat)), i });
+        }
+        std::sort(indices.begin(), indices.end());
+        std::vector<const domain::Stop*> ordered_stops;
+        ordered_stops.reserve(stops.size());
+        for (const auto& [index, position] : indices) {
+            ordered_stops.push_back(stops[position]);
+        }
+        return ordered_stops;
+    }
+
+    std::vector<const domain::Bus*> TransportRouter::OrderBuses(const std::vector<const domain::Stop*>& stops) const {
+        std::vector<const domain::Bus*> buses;
+        for (const auto& [bus_name, bus_ptr] : catalogue_.GetSortedBuses()) {
+            buses.push_back(bus_ptr);
+        }
+        if (!routing_settings_.use_hilbert_order) {
+            return buses;
+        }
+        std::unordered_map<const domain::Stop*, size_t> stop_positions;
+        for (size_t i = 0; i < stops.size(); ++i) {
+            stop_positions[stops[i]] = i;
+        }
+        auto get_position = [&stop_positions](const domain::Bus* bus) {
+            return bus->stops.empty() ? 0 : stop_positions.at(bus->stops.front());
+        };
+        std::stable_sort(buses.begin(), buses.end(), [&get_position](const domain::Bus* lhs, const domain::Bus* rhs) {
+            return get_position(lhs) < get_position(rhs);
+        });
+        return buses;
+    }
+
+    std::vector<std::vector<uint32_t>> TransportRouter::PartitionVertices() const {
+        // The cells are computed for the stop vertices, which come first and are the only ones with a stop
+        std::vector<IndexedCoordinates> stops;
+        for (graph::VertexId vertex = 0; vertex < vertex_stops_.size(); ++vertex) {
+            if (vertex_stops_[vertex] != nullptr) {
+                stops.push_back({ vertex_stops_[vertex]->coordinates, vertex });
+            }
+        }
+        const size_t cell_size = std::max<size_t>(routing_settings_.partition_cell_size, 1);
+        int depth = 0;
+        while (depth < 31 && ((stops.size() + (size_t(1) << depth) - 1) >> depth) > cell_size) {
+            ++depth;
+        }
+        std::vector<uint32_t> stop_cells(vertex_stops_.size(), 0);
+        BisectStops(stops.begin(), stops.end(), depth, 0, stop_cells);
+
+        // The stop vertex of every vertex: the one before the wait edge, the one of the stop of a riding vertex
+        const bool is_collapsed = routing_settings_.graph_model == GraphModel::COLLAPSED;
+        std::vector<graph::VertexId> stop_vertices(graph_.GetVertexCount());
+        for (graph::VertexId vertex = 0; vertex < vertex_stops_.size(); ++vertex) {
+            stop_vertices[vertex] = is_collapsed ? vertex : vertex / 2 * 2;
+        }
+        if (routing_settings_.graph_model == GraphModel::RIDING) {
+            graph::VertexId riding_vertex = first_riding_vertex_;
+            for (const domain::Bus* bus_ptr : riding_buses_) {
+                for (const domain::Stop* stop : bus_ptr->stops) {
+                    stop_vertices[riding_vertex++] = stops_id_.at(stop->name);
+                }
+            }
+        }
+
+        std::vector<std::vector<uint32_t>> vertex_cells;
+        for (int shift = 0; shift == 0 || depth - shift >= LEVEL_SPLIT_COUNT; shift += LEVEL_SPLIT_COUNT) {
+            std::vector<uint32_t>& cells = vertex_cells.emplace_back(stop_vertices.size());
+            for (size_t vertex = 0; vertex < stop_vertices.size(); ++vertex) {
+                cells[vertex] = stop_cells[stop_vertices[vertex]] >> shift;
+            }
+        }
+        return vertex_cells;
+    }
+
+    uint64_t TransportRouter::ComputeCacheKey() const {
+        if (routing_settings_.cache_path.empty()) {
+            return 0;
+        }
+        routing_cache::Hasher hasher;
+        hasher.Add(routing_cache::FILE_VERSION);
+        hasher.Add(routing_settings_.bus_wait_time);
+        hasher.Add(routing_settings_.bus_velocity);
+        hasher.Add(static_cast<int>(routing_settings_.graph_model));
+        hasher.Add(routing_settings_.prune_parallel_edges);
+        // Float and fixed-point tables have cells of the same size
+        hasher.Add(routing_settings_.use_fixed_point_tables);
+        // The order of the stops is the order of the vertices, so of the table rows
+        hasher.Add(routing_settings_.use_hilbert_order);
+        hasher.Add(routing_settings_.walk_radius);
+        hasher.Add(routing_settings_.walk_velocity);
+        for (const auto& [stop_name, stop_ptr] : catalogue_.GetSortedStops()) {
+            hasher.Add(stop_name);
+            hasher.Add(stop_ptr->coordinates.lat);
+            hasher.Add(stop_ptr->coordinates.lng);
+        }
+        for (const auto& [bus_name, bus_ptr] : catalogue_.GetSortedBuses()) {
+            hasher.Add(bus_name);
+            hasher.Add(static_cast<int>(bus_ptr->bus_type));
+            hasher.Add(bus_ptr->stops.size());
+            for (size_t i = 0; i < bus_ptr->stops.size(); ++i) {
+                hasher.Add(bus_ptr->stops[i]->name);
+                if (i + 1 < bus_ptr->stops.size()) {
+                    hasher.Add(catalogue_.GetDistance(bus_ptr->stops[i], bus_ptr->stops[i + 1]));
+                }
+            }
+        }
+        // Closed stops and buses change the weights of their edges, hashed by the names to be independent of the addresses
+        auto add_closed_names = [&hasher](const auto& closed_items) {
+            std::vector<std::string_view> names;
+            for (const auto* item : closed_items) {
+                names.push_back(item->name);
+            }
+            std::sort(names.begin(), names.end());
+            hasher.Add(names.size());
+            for (const std::string_view name : names) {
+                hasher.Add(name);
+            }
+        };
+        add_closed_names(disabled_stops_);
+        add_closed_names(disabled_buses_);
+        return hasher.GetHash();
     }
 
     const graph::DirectedWeightedGraph<double>& TransportRouter::GetGraph() const {
         return graph_;
     }
 
-    std::optional<graph::Router<double>::RouteInfo> TransportRouter::CalculateOptimalRoute(std::string_view stop_from, std::string_view stop_to) const {
-        return router_->BuildRoute(stops_id_.at(stop_from), stops_id_.at(stop_to));
+    GraphStats TransportRouter::GetGraphStats() const {
+        return { graph_.GetVertexCount(), graph_.GetEdgeCount(), pruned_edge_count_ };
+    }
+
+    void TransportRouter::RefreshStopEdges(const domain::Stop* stop, EdgeWeights& old_weights) {
+        // Under GraphModel::COLLAPSED the wait is a part of the bus edges
+        if (routing_settings_.graph_model != GraphModel::COLLAPSED) {
+            const bool is_open = disabled_stops_.count(stop) == 0;
+            SetEdgeWeight(stop_wait_edges_.at(stop),
+                is_open ? static_cast<double>(routing_settings_.bus_wait_time) : CLOSED_WEIGHT, old_weights);
+        }
+        // Nobody walks to or from a disabled stop
+        if (const auto it = stop_walk_edges_.find(stop); it != stop_walk_edges_.end()) {
+            for (const graph::EdgeId edge_id : it->second) {
+                const auto& edge = graph_.GetEdge(edge_id);
+                const domain::Stop* from = vertex_stops_[edge.from];
+                const domain::Stop* to = vertex_stops_[edge.to];
+                const bool is_open = disabled_stops_.count(from) == 0 && disabled_stops_.count(to) == 0;
+                SetEdgeWeight(edge_id, is_open ? ComputeWalkTime(from, to) : CLOSED_WEIGHT, old_weights);
+            }
+        }
+    }
+
+    void TransportRouter::RefreshBusEdges(const domain::Bus* bus, EdgeWeights& old_weights) {
+        if (routing_settings_.graph_model == GraphModel::RIDING) {
+            RefreshRidingEdges(bus, old_weights);
+            return;
+        }
+        // The same edges in the same order as FillGraphByBuses adds them
+        const double coeff = 1000.0 / 60.0;
+        const bool is_collapsed = routing_settings_.graph_model == GraphModel::COLLAPSED;
+        const double boarding_time = is_collapsed ? static_cast<double>(routing_settings_.bus_wait_time) : 0.0;
+        const bool is_bus_enabled = disabled_buses_.count(bus) == 0;
+        graph::EdgeId edge_id = bus_first_edges_.at(bus);
+        const size_t stops_count = bus->stops.size();
+        for (size_t i = 0; i < stops_count; ++i) {
+            // Boarding at a closed stop is stopped by its wait edge, which the collapsed graph does not have
+            const bool is_boarding_open = is_bus_enabled && (!is_collapsed || disabled_stops_.count(bus->stops[i]) == 0);
+            double distance = 0.0;
+            for (size_t j = i + 1; j < stops_count; ++j) {
+                distance += catalogue_.GetDistance(bus->stops[j - 1], bus->stops[j]);
+                const double ride_time = distance / (routing_settings_.bus_velocity * coeff);
+                if (is_collapsed) {
+                    ride_times_[edge_id] = ride_time;
+                }
+                const bool is_open = is_boarding_open && disabled_stops_.count(bus->stops[j]) == 0;
+                SetEdgeWeight(edge_id++, is_open ? boarding_time + ride_time : CLOSED_WEIGHT, old_weights);
+            }
+        }
+    }
+
+    void TransportRouter::RefreshRidingEdges(const domain::Bus* bus, EdgeWeights& old_weights) {
+        // The same edges in the same order as FillGraphByRides adds them
+        const size_t stops_count = bus->stops.size();
+        if (stops_count == 0) {
+            return;
+        }
+        const bool is_bus_enabled = disabled_buses_.count(bus) == 0;
+        graph::EdgeId edge_id = bus_first_edges_.at(bus);
+        const graph::VertexId first_vertex = graph_.GetEdge(edge_id).to;
+        double distance = 0.0;
+        for (size_t i = 0; i < stops_count; ++i) {
+            if (i > 0) {
+                distance += catalogue_.GetDistance(bus->stops[i - 1], bus->stops[i]);
+            }
+            riding_distances_[first_vertex + i - first_riding_vertex_] = distance;
+            SetEdgeWeight(edge_id++, is_bus_enabled ? 0.0 : CLOSED_WEIGHT, old_weights);
+            SetEdgeWeight(edge_id++, disabled_stops_.count(bus->stops[i]) == 0 ? 0.0 : CLOSED_WEIGHT, old_weights);
+            if (i + 1 < stops_count) {
+                SetEdgeWeight(edge_id++, ComputeRideTime(catalogue_.GetDistance(bus->stops[i], bus->stops[i + 1])), old_weights);
+            }
+        }
+    }
+
+    void TransportRouter::SetEdgeWeight(graph::EdgeId edge_id, double weight, EdgeWeights& old_weights) {
+        const double old_weight = graph_.GetEdge(edge_id).weight;
+        if (old_weight == weight) {
+            return;
+        }
+        old_weights.push_back({ edge_id, old_weight });
+        graph_.SetEdgeWeight(edge_id, weight);
+        if (frozen_graph_.GetEdgeCount() > 0) {
+            frozen_graph_.SetEdgeWeight(edge_id, weight);
+        }
+    }
+
+    void TransportRouter::ApplyEdgeChanges(const EdgeWeights& old_weights) {
+        if (!router_->UpdateEdgeWeights(old_weights)) {
+            CreateRouter();
+        }
+    }
+
+    void TransportRouter::UpdateDistance(std::string_view stop_from, std::string_view stop_to) {
+        const domain::Stop* from = FindStop(stop_from);
+        const domain::Stop* to = FindStop(stop_to);
+
+        // The distance is used in both directions unless the other one is set on its own
+        std::vector<const domain::Bus*> affected_buses;
+        for (const uint32_t bus_id : catalogue_.GetStopBusIds(from)) {
+            const domain::Bus* bus = catalogue_.GetBus(bus_id);
+            for (size_t i = 0; i + 1 < bus->stops.size(); ++i) {
+                if ((bus->stops[i] == from && bus->stops[i + 1] == to) || (bus->stops[i] == to && bus->stops[i + 1] == from)) {
+                    affected_buses.push_back(bus);
+                    break;
+                }
+            }
+        }
+
+        if (raptor_router_) {
+            for (const domain::Bus* bus : affected_buses) {
+                raptor_router_->UpdateBus(bus);
+            }
+            return;
+        }
+        if (routing_settings_.prune_parallel_edges) {
+            CreateGraph();
+            return;
+        }
+        EdgeWeights old_weights;
+        for (const domain::Bus* bus : affected_buses) {
+            RefreshBusEdges(bus, old_weights);
+        }
+        ApplyEdgeChanges(old_weights);
+    }
+
+    void TransportRouter::SetStopEnabled(std::string_view stop_name, bool is_enabled) {
+        const domain::Stop* stop = FindStop(stop_name);
+        const bool is_changed = is_enabled ? disabled_stops_.erase(stop) > 0 : disabled_stops_.insert(stop).second;
+        if (!is_changed) {
+            return;
+        }
+        if (raptor_router_) {
+            raptor_router_->SetStopEnabled(stop, is_enabled);
+            return;
+        }
+        if (routing_settings_.prune_parallel_edges) {
+            CreateGraph();
+            return;
+        }
+        EdgeWeights old_weights;
+        RefreshStopEdges(stop, old_weights);
+        for (const uint32_t bus_id : catalogue_.GetStopBusIds(stop)) {
+            RefreshBusEdges(catalogue_.GetBus(bus_id), old_weights);
+        }
+        ApplyEdgeChanges(old_weights);
+    }
+
+    void TransportRouter::SetBusEnabled(std::string_view bus_name, bool is_enabled) {
+        const domain::Bus* bus = catalogue_.FindBus(bus_name);
+        if (bus == nullptr) {
+            throw std::out_of_range("Unknown bus: " + std::string(bus_name));
+        }
+        const bool is_changed = is_enabled ? disabled_buses_.erase(bus) > 0 : disabled_buses_.insert(bus).second;
+        if (!is_changed) {
+            return;
+        }
+        if (raptor_router_) {
+            raptor_router_->SetBusEnabled(bus, is_enabled);
+            return;
+        }
+        if (routing_settings_.prune_parallel_edges) {
+            CreateGraph();
+            return;
+        }
+        EdgeWeights old_weights;
+        RefreshBusEdges(bus, old_weights);
+        ApplyEdgeChanges(old_weights);
+    }
+
+    Route TransportRouter::MakeRoute(const graph::RouterBase<double>::RouteInfo& route_info) const {
+        if (routing_settings_.graph_model == GraphModel::RIDING) {
+            return MakeRidingRoute(route_info);
+        }
+        if (routing_settings_.graph_model == GraphModel::COLLAPSED) {
+            return MakeCollapsedRoute(route_info);
+        }
+        Route route;
+        route.items.reserve(route_info.edges.size());
+        for (const graph::EdgeId edge_id : route_info.edges) {
+            const auto& edge = graph_.GetEdge(edge_id);
+            route.total_time += edge.weight;
+            route.items.push_back({ edge.items_type, edge.name, edge.span_count, edge.weight, GetWalkTarget(edge) });
+        }
+        return route;
+    }
+
+    std::string_view TransportRouter::GetWalkTarget(const graph::Edge<double>& edge) const {
+        return edge.items_type == graph::ItemsType::WALK ? vertex_stops_[edge.to]->name : std::string_view();
+    }
+
+    Route TransportRouter::MakeRidingRoute(const graph::RouterBase<double>::RouteInfo& route_info) const {
+        // Hops are folded into one ride from the boarding to the alighting, timed by the whole distance
+        // so that the time is the same as the one of the edge of GraphModel::STOP_PAIRS
+        Route route;
+        graph::VertexId board_vertex = 0;
+        for (const graph::EdgeId edge_id : route_info.edges) {
+            const auto& edge = graph_.GetEdge(edge_id);
+            if (edge.items_type == graph::ItemsType::WAIT || edge.items_type == graph::ItemsType::WALK) {
+                route.total_time += edge.weight;
+                route.items.push_back({ edge.items_type, edge.name, edge.span_count, edge.weight, GetWalkTarget(edge) });
+            }
+            else if (edge.items_type == graph::ItemsType::DEFAULT && edge.to >= first_riding_vertex_) {
+                board_vertex = edge.to;
+            }
+            else if (edge.items_type == graph::ItemsType::DEFAULT) {
+                const double time = ComputeRideTime(riding_distances_[edge.from - first_riding_vertex_]
+                    - riding_distances_[board_vertex - first_riding_vertex_]);
+                route.total_time += time;
+                route.items.push_back({ graph::ItemsType::BUS, edge.name, static_cast<int>(edge.from - board_vertex), time, {} });
+            }
+        }
+        return route;
+    }
+
+    Route TransportRouter::MakeCollapsedRoute(const graph::RouterBase<double>::RouteInfo& route_info) const {
+        // Every edge is the wait at its first stop and the ride, summed up in the order of the two-vertex graph
+        const double wait_time = static_cast<double>(routing_settings_.bus_wait_time);
+        Route route;
+        route.items.reserve(route_info.edges.size() * 2);
+        for (const graph::EdgeId edge_id : route_info.edges) {
+            const auto& edge = graph_.GetEdge(edge_id);
+            if (edge.items_type == graph::ItemsType::WALK) {
+                route.total_time += ride_times_[edge_id];
+                route.items.push_back({ edge.items_type, edge.name, 0, ride_times_[edge_id], GetWalkTarget(edge) });
+                continue;
+            }
+            route.total_time += wait_time;
+            route.items.push_back({ graph::ItemsType::WAIT, vertex_stops_[edge.from]->name, 0, wait_time, {} });
+            route.total_time += ride_times_[edge_id];
+            route.items.push_back({ edge.items_type, edge.name, edge.span_count, ride_times_[edge_id], {} });
+        }
+        return route;
+    }
+
+    Route TransportRouter::MakeRoute(const raptor_router::Journey& journey) const {
+        const double wait_time = static_cast<double>(routing_settings_.bus_wait_time);
+        Route route;
+        route.items.reserve(journey.legs.size() * 2);
+        for (const raptor_router::Leg& leg : journey.legs) {
+            if (leg.bus == nullptr) {
+                route.total_time += leg.ride_time;
+                route.items.push_back({ graph::ItemsType::WALK, leg.walk_from->name, 0, leg.ride_time, leg.walk_to->name });
+                continue;
+            }
+            route.total_time += wait_time;
+            route.items.push_back({ graph::ItemsType::WAIT, leg.bus->stops[leg.board_index]->name, 0, wait_time, {} });
+            route.total_time += leg.ride_time;
+            route.items.push_back({ graph::ItemsType::BUS, leg.bus->name, static_cast<int>(leg.alight_index - leg.board_index),
+                leg.ride_time, {} });
+        }
+        return route;
+    }
+
+    const domain::Stop* TransportRouter::FindStop(std::string_view stop_name) const {
+        const domain::Stop* stop = catalogue_.FindStop(stop_name);
+        if (stop == nullptr) {
+            throw std::out_of_range("Unknown stop: " + std::string(stop_name));
+        }
+        return stop;
+    }
+
+    std::optional<Route> TransportRouter::CalculateOptimalRoute(std::string_view stop_from, std::string_view stop_to) const {
+        if (raptor_router_) {
+            if (auto journey = raptor_router_->BuildJourney(FindStop(stop_from), FindStop(stop_to))) {
+                return MakeRoute(*journey);
+            }
+            return std::nullopt;
+        }
+        if (auto route_info = router_->BuildRoute(stops_id_.at(stop_from), stops_id_.at(stop_to))) {
+            return MakeRoute(*route_info);
+        }
+        return std::nullopt;
+    }
+
+    std::vector<std::vector<std::optional<Route>>> TransportRouter::CalculateRouteMatrix(
+        const std::vector<std::string_view>& stops_from, const std::vector<std::string_view>& stops_to) const {
+        std::vector<std::vector<std::optional<Route>>> routes(stops_from.size());
+
+        if (raptor_router_) {
+            std::vector<const domain::Stop*> targets;
+            targets.reserve(stops_to.size());
+            for (const std::string_view stop_to : stops_to) {
+                targets.push_back(FindStop(stop_to));
+            }
+            std::vector<const domain::Stop*> sources;
+            sources.reserve(stops_from.size());
+            for (const std::string_view stop_from : stops_from) {
+                sources.push_back(FindStop(stop_from));
+            }
+            thread_pool_->ParallelFor(sources.size(), [&](size_t i) {
+                for (auto& journey : raptor_router_->BuildJourneys(sources[i], targets)) {
+                    routes[i].push_back(journey ? std::optional<Route>(MakeRoute(*journey)) : std::nullopt);
+                }
+            });
+            return routes;
+        }
+
+        std::vector<graph::VertexId> targets;
+        targets.reserve(stops_to.size());
+        for (const std::string_view stop_to : stops_to) {
+            targets.push_back(stops_id_.at(stop_to));
+        }
+        std::vector<graph::VertexId> sources;
+        sources.reserve(stops_from.size());
+        for (const std::string_view stop_from : stops_from) {
+            sources.push_back(stops_id_.at(stop_from));
+        }
+        thread_pool_->ParallelFor(sources.size(), [&](size_t i) {
+            for (auto& route_info : router_->BuildRoutes(sources[i], targets)) {
+                routes[i].push_back(route_info ? std::optional<Route>(MakeRoute(*route_info)) : std::nullopt);
+            }
+        });
+        return routes;
+    }
+
+    std::vector<ReachableStop> TransportRouter::CalculateReachableStops(std::string_view stop_from, double time_limit) const {
+        std::vector<ReachableStop> stops;
+        if (raptor_router_) {
+            for (const auto& [stop, time] : raptor_router_->FindReachableStops(FindStop(stop_from), time_limit)) {
+                stops.push_back({ stop->name, time });
+            }
+        }
+        else {
+            FindStop(stop_from);
+            for (const auto& [vertex, time] : graph::FindVerticesWithinLimit(graph_, stops_id_.at(stop_from), time_limit)) {
+                if (vertex < vertex_stops_.size() && vertex_stops_[vertex] != nullptr) {
+                    stops.push_back({ vertex_stops_[vertex]->name, time });
+                }
+            }
+        }
+        std::sort(stops.begin(), stops.end(), [](const ReachableStop& lhs, const ReachableStop& rhs) {
+            return std::make_pair(lhs.time, lhs.name) < std::make_pair(rhs.time, rhs.name);
+        });
+        return stops;
     }
 
 } // namespace transport_router
\ No newline at end of file
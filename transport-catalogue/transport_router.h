@@ -1,15 +1,92 @@
 #pragma once
 
+#include "alt_router.h"
+#include "contraction_hierarchy.h"
+#include "csr_graph.h"
+#include "dijkstra_router.h"
+#include "partition_router.h"
+#include "raptor_router.h"
 #include "router.h"
+#include "routing_cache.h"
+#include "thread_pool.h"
 #include "transport_catalogue.h"
 
+#include <limits>
 #include <memory>
+#include <optional>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 namespace transport_router {
 
+    enum class RouterType {
+        ALL_PAIRS, // precompute of all routes at construction, O(V^2) memory
+        DIJKSTRA,  // search on every request, O(V + E) memory
+        CONTRACTION_HIERARCHY, // contraction preprocessing, bidirectional upward search on every request
+        ALT,       // A* search on every request with bounds from landmark distances, O(L * V) memory
+        RAPTOR,    // round-based search over the bus routes on every request, no routing graph at all
+        PARTITION, // overlay cliques of geographic cells, graph search only in the cells of the source and the target
+        AUTO       // one of the graph engines, chosen by the budgets of the settings once the graph is built
+    };
+
+    enum class GraphModel {
+        STOP_PAIRS, // an edge for every pair of stops of a bus, O(k^2) edges for a bus of k stops
+        RIDING,     // a vertex for every stop of every bus joined by one edge per hop, O(k) edges and vertices
+        COLLAPSED   // as STOP_PAIRS with the wait folded into the bus edges, one vertex per stop instead of two
+    };
+
     struct RoutingSettings {
         int bus_wait_time = 0;
         double bus_velocity = 0.0;
+        RouterType router_type = RouterType::ALL_PAIRS;
+        GraphModel graph_model = GraphModel::STOP_PAIRS;
+        bool use_compact_tables = false; // float weights in the all-pairs tables, half of the memory
+        // Integer milliseconds in the all-pairs tables, half of the memory, exact sums. Routes must be shorter than
+        // about 298 hours, the router falls back to use_compact_tables for networks with longer ones.
+        bool use_fixed_point_tables = false;
+        std::string cache_path;          // file to keep the all-pairs tables between runs, empty to disable
+        size_t landmark_count = 8;       // landmarks of the ALT router
+        size_t partition_cell_size = 64; // RouterType::PARTITION: the most stops in a cell of the finest level
+        bool use_hilbert_order = false;  // stops numbered along a Hilbert curve over the coordinates instead of by the names
+        double walk_radius = 0.0;        // meters of the longest walk between two stops, 0 for no walking transfers
+        double walk_velocity = 5.0;      // km/h
+        bool prune_parallel_edges = false; // only the lightest edge between two vertices, live changes rebuild the graph
+        size_t memory_budget = size_t(1) << 30; // RouterType::AUTO: bytes for the precomputed state of the router
+        double precompute_time_budget = 10.0;   // RouterType::AUTO: seconds for the precompute, a cache hit costs none
+        // RouterType::AUTO: seconds of the double all-pairs precompute per vertex_count^3 on one thread, the float tables
+        // take half of it. Measured 0.6e-9 to 0.9e-9 on graphs of 1200 vertices at -O2, rounded up; calibrate for the host.
+        double all_pairs_seconds_per_step = 1e-9;
+        bool log_router_choice = false;         // RouterType::AUTO: the chosen strategy and its estimates to std::cerr
+    };
+
+    // Size of the routing graph as it was built
+    struct GraphStats {
+        size_t vertex_count = 0;
+        size_t edge_count = 0;
+        size_t pruned_edge_count = 0; // removed by RoutingSettings::prune_parallel_edges
+    };
+
+    // Part of a route: the wait at a stop before boarding, the ride on a bus over span_count stops,
+    // or the walk from one stop to another
+    struct RouteItem {
+        graph::ItemsType type = graph::ItemsType::DEFAULT;
+        std::string_view name; // stop name for the wait, bus name for the ride, the stop the walk starts at
+        int span_count = 0;
+        double time = 0.0;
+        std::string_view walk_to;
+    };
+
+    struct Route {
+        double total_time = 0.0;
+        std::vector<RouteItem> items;
+    };
+
+    // Stop with the earliest arrival at it
+    struct ReachableStop {
+        std::string_view name;
+        double time = 0.0;
     };
 
     class TransportRouter {
@@ -17,23 +94,138 @@ namespace transport_router {
         TransportRouter(RoutingSettings routing_settings, const transport_catalogue::TransportCatalogue& catalogue)
             : routing_settings_(routing_settings)
             , catalogue_(catalogue)
+            , thread_pool_(std::make_unique<thread_pool::ThreadPool>())
         {
             CreateGraph();
+            is_initial_build_ = false;
         }
 
         const graph::DirectedWeightedGraph<double>& GetGraph() const;
-        std::optional<graph::Router<double>::RouteInfo> CalculateOptimalRoute(std::string_view stop_from, std::string_view stop_to) const;
+        GraphStats GetGraphStats() const;
+        std::optional<Route> CalculateOptimalRoute(std::string_view stop_from, std::string_view stop_to) const;
+
+        // Routes between all stops_from and all stops_to: row i holds the routes from stops_from[i] in the order of stops_to.
+        // Rows are computed in parallel, each by a single search where the router supports it.
+        std::vector<std::vector<std::optional<Route>>> CalculateRouteMatrix(
+            const std::vector<std::string_view>& stops_from, const std::vector<std::string_view>& stops_to) const;
+
+        // Stops reachable from stop_from within time_limit minutes, the source included, by the arrival time and the name.
+        // A single search bounded by the limit, it does not look beyond the reachable stops.
+        std::vector<ReachableStop> CalculateReachableStops(std::string_view stop_from, double time_limit) const;
+
+        // Live changes of the network. Only the edges derived from the changed data are re-weighted, then the router
+        // repairs its precomputed state or, if it can not, is built anew over the same graph.
+        // The owner of the catalogue sets the new distance in it first, the router re-reads the distance between the stops.
+        void UpdateDistance(std::string_view stop_from, std::string_view stop_to);
+
+        // Nobody boards or alights at a disabled stop, buses still pass it. A disabled bus is not used at all.
+        void SetStopEnabled(std::string_view stop_name, bool is_enabled);
+        void SetBusEnabled(std::string_view bus_name, bool is_enabled);
 
     private:
+        using EdgeWeights = std::vector<std::pair<graph::EdgeId, double>>;
+
+        // Weight of the edges which can not be used at the moment
+        static constexpr double CLOSED_WEIGHT = std::numeric_limits<double>::infinity();
+
         RoutingSettings routing_settings_;
         const transport_catalogue::TransportCatalogue& catalogue_;
+        // Workers of the graph construction, the route matrices and the routing engines, started once for the lifetime
+        // of the router, so live changes do not start threads
+        std::unique_ptr<thread_pool::ThreadPool> thread_pool_;
         graph::DirectedWeightedGraph<double> graph_;
-        std::unique_ptr<graph::Router<double>> router_;
+        graph::CsrGraph<double> frozen_graph_; // graph_ in the layout of the on-demand searches
+        std::unique_ptr<graph::RouterBase<double>> router_;
+        std::unique_ptr<raptor_router::RaptorRouter> raptor_router_; // replaces the graph and router_ for RouterType::RAPTOR
         std::unordered_map<std::string_view, graph::VertexId> stops_id_;
 
-        void FillGraphByStops();
+        // Edges of every stop and bus, to re-weight them on changes
+        std::unordered_map<const domain::Stop*, graph::EdgeId> stop_wait_edges_;
+        std::unordered_map<const domain::Bus*, graph::EdgeId> bus_first_edges_;
+        std::unordered_map<const domain::Stop*, std::vector<graph::EdgeId>> stop_walk_edges_; // from the stop and to it
+        std::unordered_set<const domain::Stop*> disabled_stops_;
+        std::unordered_set<const domain::Bus*> disabled_buses_;
+
+        // GraphModel::RIDING: the riding vertices follow the stop vertices, bus by bus in the order of riding_buses_
+        // and of bus->stops; the road distance from the first stop of the bus is kept for every one of them
+        graph::VertexId first_riding_vertex_ = 0;
+        std::vector<const domain::Bus*> riding_buses_;
+        std::vector<double> riding_distances_;
+
+        // The stop of every arrival vertex, null for the other vertices
+        std::vector<const domain::Stop*> vertex_stops_;
+
+        // GraphModel::COLLAPSED: the time on the bus of every edge, without the wait
+        std::vector<double> ride_times_;
+
+        size_t pruned_edge_count_ = 0;
+
+        // The all-pairs tables are saved to the cache only when the router is constructed, the rebuilds after
+        // live changes would spend a write of the whole table on every closure
+        bool is_initial_build_ = true;
+
+        // Stops in the order of their vertices: by the names or along the Hilbert curve
+        std::vector<const domain::Stop*> OrderStops() const;
+
+        // Buses in the order of their riding vertices: by the names or by the first stops in the order of the stops
+        std::vector<const domain::Bus*> OrderBuses(const std::vector<const domain::Stop*>& stops) const;
+
+        void FillGraphByStops(const std::vector<const domain::Stop*>& stops);
         void FillGraphByBuses();
+        void FillGraphByRides();
+        void FillGraphByWalks(const std::vector<const domain::Stop*>& stops);
         void CreateGraph();
+        void CreateRouter();
+        void PruneParallelEdges();
+
+        // Resolves RouterType::AUTO from the estimated size and precompute time of every engine on the built graph.
+        // An all-pairs router is created right away, over the cached tables the choice has loaded.
+        void ChooseRouterType();
+
+        template <typename TableWeight>
+        using CachedTable = std::optional<typename graph::Router<double, TableWeight>::TableView>;
+
+        // Tables of the current graph from the cache file, nothing without the cache or if it is stale
+        template <typename TableWeight>
+        CachedTable<TableWeight> LoadCachedTable(uint64_t cache_key) const;
+
+        // Recomputes the weights of the edges, collecting the changed ones with their old weights
+        void RefreshStopEdges(const domain::Stop* stop, EdgeWeights& old_weights);
+        void RefreshBusEdges(const domain::Bus* bus, EdgeWeights& old_weights);
+        void RefreshRidingEdges(const domain::Bus* bus, EdgeWeights& old_weights);
+        void SetEdgeWeight(graph::EdgeId edge_id, double weight, EdgeWeights& old_weights);
+        void ApplyEdgeChanges(const EdgeWeights& old_weights);
+
+        Route MakeRoute(const graph::RouterBase<double>::RouteInfo& route_info) const;
+        Route MakeRoute(const raptor_router::Journey& journey) const;
+        Route MakeRidingRoute(const graph::RouterBase<double>::RouteInfo& route_info) const;
+        Route MakeCollapsedRoute(const graph::RouterBase<double>::RouteInfo& route_info) const;
+        double ComputeRideTime(double distance) const;
+        std::string_view GetWalkTarget(const graph::Edge<double>& edge) const;
+
+        // Walks between the stops not farther apart than walk_radius, both ways, found by a grid join of the coordinates
+        std::vector<raptor_router::Transfer> FindWalkingTransfers(const std::vector<const domain::Stop*>& stops) const;
+        double ComputeWalkTime(const domain::Stop* from, const domain::Stop* to) const;
+        const domain::Stop* FindStop(std::string_view stop_name) const;
+
+        // Stops spread over the map by farthest point sampling of the coordinates
+        std::vector<graph::VertexId> SelectLandmarks() const;
+
+        // Cells of every vertex, level by level, for RouterType::PARTITION: the stops are bisected by the coordinates
+        // into cells of partition_cell_size stops at most, every higher level merges a few cells of the level below.
+        // A vertex is in the cell of its stop.
+        std::vector<std::vector<uint32_t>> PartitionVertices() const;
+
+        // Hash of everything the graph is built from: the catalogue, the routing settings and the closures.
+        // 0 without the cache file, nothing is looked up then.
+        uint64_t ComputeCacheKey() const;
+
+        // Router over the cached tables or, without them, over a new precompute which is saved to the cache
+        template <typename TableWeight>
+        void CreateAllPairsRouter(uint64_t cache_key, CachedTable<TableWeight> cached_table);
+
+        // RoutingSettings::use_fixed_point_tables: the float tables if the network has routes beyond the fixed-point range
+        void CreateFixedPointRouter(uint64_t cache_key, CachedTable<uint32_t> cached_table);
     };
 
 } // namespace transport_router
\ No newline at end of file